@@ -0,0 +1,131 @@
+// Compares the Network delivery structures at a large number of in-flight
+// messages: one global binary heap versus the sharded hierarchical timing wheel,
+// first as bare structures, then through Network::send_message from concurrent senders.
+#include "timing_wheel.hpp"
+#include "network.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+struct Envelope {
+    uint32_t from_id;
+    uint32_t to_id;
+    std::string content;
+    int64_t due_tick;
+
+    bool operator<(const Envelope& other) const {
+        return due_tick > other.due_tick;  // For min-heap priority queue
+    }
+};
+
+constexpr size_t num_shards = 16;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::vector<Envelope> make_messages(size_t count, uint32_t num_nodes) {
+    std::mt19937 rng(42);
+    std::normal_distribution<double> delay(50.0, 10.0);
+    std::vector<Envelope> messages;
+    messages.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        int64_t due = static_cast<int64_t>(i / 1000) + std::max<int64_t>(0, static_cast<int64_t>(delay(rng)));
+        messages.push_back({static_cast<uint32_t>(rng() % num_nodes), static_cast<uint32_t>(rng() % num_nodes),
+                            "gossip_payload", due});
+    }
+    return messages;
+}
+
+void bench_heap(std::vector<Envelope> messages) {
+    std::priority_queue<Envelope> heap;
+    auto start = std::chrono::steady_clock::now();
+    for (auto& msg : messages) {
+        heap.push(std::move(msg));
+    }
+    double insert_ms = elapsed_ms(start);
+
+    start = std::chrono::steady_clock::now();
+    size_t delivered = 0;
+    for (int64_t now = 0; !heap.empty(); now += 10) {
+        while (!heap.empty() && heap.top().due_tick <= now) {
+            heap.pop();
+            delivered++;
+        }
+    }
+    std::cout << "heap          insert " << insert_ms << " ms, drain " << elapsed_ms(start)
+              << " ms, delivered " << delivered << "\n";
+}
+
+void bench_wheel(std::vector<Envelope> messages) {
+    std::vector<TimingWheel<Envelope>> shards(num_shards);
+    auto start = std::chrono::steady_clock::now();
+    for (auto& msg : messages) {
+        int64_t due = msg.due_tick;
+        shards[msg.to_id % num_shards].insert(due, std::move(msg));
+    }
+    double insert_ms = elapsed_ms(start);
+
+    start = std::chrono::steady_clock::now();
+    size_t delivered = 0;
+    size_t remaining = messages.size();
+    for (int64_t now = 0; remaining > 0; now += 10) {
+        for (auto& shard : shards) {
+            shard.advance(now, [&](Envelope&&) {
+                delivered++;
+                remaining--;
+            });
+        }
+    }
+    std::cout << "timing wheel  insert " << insert_ms << " ms, drain " << elapsed_ms(start)
+              << " ms, delivered " << delivered << "\n";
+}
+
+// Whole send path: routing, envelope pool and enqueue; messages stay in flight
+void bench_network(Network::DeliveryQueue kind, const char* name, size_t in_flight, size_t senders,
+                   uint32_t num_nodes) {
+    Network network(nullptr, kind);
+    network.set_seed(42);
+    size_t per_sender = in_flight / senders;
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < senders; ++t) {
+        threads.emplace_back([&network, t, per_sender, num_nodes]() {
+            NodeId from = static_cast<NodeId>(t);
+            for (size_t i = 0; i < per_sender; ++i) {
+                network.send_message(from, static_cast<NodeId>((t * 7919 + i * 31) % num_nodes), "gossip_payload");
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double send_ms = elapsed_ms(start);
+    std::cout << name << senders << " senders, send " << send_ms << " ms ("
+              << static_cast<uint64_t>(static_cast<double>(per_sender * senders) / send_ms * 1000.0)
+              << " msg/s), in flight " << network.get_stats().delivered_messages << "\n";
+}
+}
+
+int main(int argc, char** argv) {
+    size_t in_flight = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    auto messages = make_messages(in_flight, 10000);
+    std::cout << in_flight << " in-flight messages\n";
+    bench_heap(messages);
+    bench_wheel(messages);
+
+    size_t max_senders = (argc > 2) ? std::strtoull(argv[2], nullptr, 10)
+                                    : std::max<size_t>(4, std::thread::hardware_concurrency());
+    for (size_t senders : {size_t{1}, max_senders}) {
+        bench_network(Network::DeliveryQueue::Heap, "network heap  ", in_flight, senders, 10000);
+        bench_network(Network::DeliveryQueue::TimingWheel, "network wheel ", in_flight, senders, 10000);
+    }
+    return 0;
+}
@@ -0,0 +1,264 @@
+// Google Benchmark suite for the detector hot paths across cluster sizes.
+// Run with --benchmark_out=<file> --benchmark_out_format=json (the
+// run_failure_detection_bench target does) to track regressions.
+#include "gossip_node.hpp"
+#include "heartbeat_node.hpp"
+#include "network.hpp"
+#include "event_scheduler.hpp"
+#include "peer_sampler.hpp"
+#include <benchmark/benchmark.h>
+#include "gossip_codec.hpp"
+#include <sstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+std::vector<std::string> cluster_ids(int64_t size) {
+    std::vector<std::string> ids;
+    for (int64_t i = 0; i < size; ++i) {
+        ids.push_back("bench" + std::to_string(i));
+    }
+    return ids;
+}
+
+// Receiver that only drops what it is sent, so network benchmarks time the network
+class SinkNode : public Node {
+public:
+    using Node::Node;
+    void send_message(const std::string&, const std::string&) override {}
+    void process_message(const Message&) override {}
+    std::vector<NodeId> get_failed_node_ids() const override { return {}; }
+    bool is_node_failed(NodeId) const override { return false; }
+
+protected:
+    void periodic_task() override {}
+};
+
+void cluster_sizes(benchmark::internal::Benchmark* bench) {
+    bench->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMicrosecond);
+}
+}
+
+static void BM_GossipSerializeState(benchmark::State& state) {
+    GossipNode node("bench0", cluster_ids(state.range(0)));
+    std::string buffer;
+    for (auto _ : state) {
+        node.serialize_state(buffer);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["bytes"] = static_cast<double>(buffer.size());
+}
+BENCHMARK(BM_GossipSerializeState)->Apply(cluster_sizes);
+
+static void BM_GossipDeserializeState(benchmark::State& state) {
+    // Every iteration gets a message whose entries are all newer than the last
+    // one, so each entry is merged rather than skipped as stale. The messages are
+    // encoded ahead in batches, outside the timed region
+    auto ids = cluster_ids(state.range(0));
+    GossipNode sender("bench0", ids);
+    GossipNode receiver("bench1", ids);
+    std::vector<NodeId> numeric_ids;
+    for (const auto& id : ids) {
+        numeric_ids.push_back(NodeRegistry::instance().intern(id));
+    }
+    std::vector<std::string> buffers(16);
+    uint64_t version = 0;
+    auto encode_batch = [&]() {
+        for (auto& buffer : buffers) {
+            GossipEncoder encoder(buffer);
+            ++version;
+            for (NodeId id : numeric_ids) {
+                encoder.add({id, true, version});
+            }
+        }
+    };
+    encode_batch();
+    size_t next = 0;
+    for (auto _ : state) {
+        if (next == buffers.size()) {
+            state.PauseTiming();
+            encode_batch();
+            next = 0;
+            state.ResumeTiming();
+        }
+        receiver.deserialize_state(buffers[next++], sender.get_numeric_id());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GossipDeserializeState)->Apply(cluster_sizes);
+
+static void BM_GossipSelectPeers(benchmark::State& state) {
+    // The sampler a GossipNode draws its fanout from each round. Second argument is
+    // the PeerSampler::Strategy; ZoneAware spreads the cluster over 4 zones
+    auto& registry = NodeRegistry::instance();
+    auto ids = cluster_ids(state.range(0));
+    PeerSampler sampler(registry.intern(ids[0]));
+    auto strategy = static_cast<PeerSampler::Strategy>(state.range(1));
+    sampler.set_strategy(strategy);
+    for (size_t i = 1; i < ids.size(); ++i) {
+        NodeId id = registry.intern(ids[i]);
+        if (strategy == PeerSampler::Strategy::ZoneAware) {
+            sampler.set_zone(id, static_cast<int>(i % 4));
+        }
+        sampler.add(id);
+    }
+    std::mt19937 rng(1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sampler.select(3, rng).data());
+    }
+}
+BENCHMARK(BM_GossipSelectPeers)->ArgsProduct({{10, 100, 1000, 10000, 100000}, {0, 1, 2}})->Unit(benchmark::kMicrosecond);
+
+static void BM_GossipPeriodicTask(benchmark::State& state) {
+    // Detached from any network, so this is the gossip round's encode plus the suspicion scan
+    auto scheduler = std::make_shared<EventScheduler>();
+    GossipNode node("bench0", cluster_ids(state.range(0)), scheduler);
+    for (auto _ : state) {
+        scheduler->run_for(1000);  // Due for a gossip round on every call
+        node.run_tick();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GossipPeriodicTask)->Apply(cluster_sizes);
+
+static void BM_GossipGetFailedNodes(benchmark::State& state) {
+    auto ids = cluster_ids(state.range(0));
+    auto scheduler = std::make_shared<EventScheduler>();
+    GossipNode node("bench0", ids, scheduler);
+    // Let every peer go stale so all of them end up in the result
+    for (int round = 0; round < 5; ++round) {
+        scheduler->run_for(1000);
+        node.run_tick();
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(node.get_failed_nodes());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GossipGetFailedNodes)->Apply(cluster_sizes);
+
+static void BM_HeartbeatIngest(benchmark::State& state) {
+    auto scheduler = std::make_shared<EventScheduler>();
+    HeartbeatNode master("bench_master", true, scheduler);
+    std::vector<NodeId> workers;
+    for (const auto& id : cluster_ids(state.range(0))) {
+        workers.push_back(NodeRegistry::instance().intern(id));
+    }
+    // Through the inbox, as the network delivers them
+    size_t next = 0;
+    for (auto _ : state) {
+        master.receive_message(workers[next], "HEARTBEAT");
+        master.process_message_queue();
+        next = (next + 1) % workers.size();
+    }
+}
+BENCHMARK(BM_HeartbeatIngest)->Apply(cluster_sizes);
+
+static void BM_HeartbeatCheckNodeHealth(benchmark::State& state) {
+    auto scheduler = std::make_shared<EventScheduler>();
+    HeartbeatNode master("bench_master", true, scheduler);
+    for (const auto& id : cluster_ids(state.range(0))) {
+        master.receive_message(id, "HEARTBEAT");
+    }
+    master.process_message_queue();
+    for (auto _ : state) {
+        // Every worker is within its deadline: the steady-state master tick
+        master.run_tick();
+    }
+}
+BENCHMARK(BM_HeartbeatCheckNodeHealth)->Apply(cluster_sizes);
+
+static void BM_NetworkSendAndProcess(benchmark::State& state) {
+    // Second argument 1 spreads the cluster over 8 groups with their own link entries
+    // (same parameters, so only the lookups differ) and cuts one group pair
+    const int messages_per_iteration = 1000;
+    auto scheduler = std::make_shared<EventScheduler>();
+    Network network(scheduler);
+    std::vector<std::shared_ptr<SinkNode>> nodes;
+    std::vector<NodeId> ids;
+    std::string topology;
+    for (const auto& id : cluster_ids(state.range(0))) {
+        nodes.push_back(std::make_shared<SinkNode>(id, scheduler));
+        network.add_node(id, nodes.back());
+        ids.push_back(nodes.back()->get_numeric_id());
+        topology += "group g" + std::to_string(ids.size() % 8) + " " + id + "\n";
+    }
+    if (state.range(1) == 1) {
+        topology += "link g0 g1 delay 50 10\nlink g2 g3 delay 50 10\nnode-link bench1 bench2\npartition g7 g0\n";
+        std::istringstream in(topology);
+        std::string error;
+        if (!network.load_topology(in, error)) {
+            state.SkipWithError(error.c_str());
+            return;
+        }
+    }
+    std::string payload(64, 'x');
+    size_t cursor = 0;
+    for (auto _ : state) {
+        for (int i = 0; i < messages_per_iteration; ++i) {
+            NodeId from = ids[cursor % ids.size()];
+            NodeId to = ids[(cursor * 7 + 1) % ids.size()];
+            network.send_message(from, to, payload);
+            cursor++;
+        }
+        scheduler->run_for(200);  // Past every delivery time
+        
+        state.PauseTiming();
+        for (auto& node : nodes) {
+            node->process_message_queue();
+        }
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * messages_per_iteration);
+}
+BENCHMARK(BM_NetworkSendAndProcess)->ArgsProduct({{10, 100, 1000, 10000, 100000}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+static void BM_NetworkAllToAllBurst(benchmark::State& state) {
+    // Every node sends two messages to every other node in the same tick, the
+    // shape of run_high_load_test; second argument 1 sends each node's burst
+    // through send_batch, so the two messages to a peer share an envelope
+    const int per_peer = 2;
+    auto scheduler = std::make_shared<EventScheduler>();
+    Network network(scheduler);
+    std::vector<std::shared_ptr<SinkNode>> nodes;
+    std::vector<NodeId> ids;
+    for (const auto& id : cluster_ids(state.range(0))) {
+        nodes.push_back(std::make_shared<SinkNode>(id, scheduler));
+        network.add_node(id, nodes.back());
+        ids.push_back(nodes.back()->get_numeric_id());
+    }
+    std::string payload(64, 'x');
+    std::vector<OutgoingMessage> burst;
+    for (NodeId to : ids) {
+        for (int k = 0; k < per_peer; ++k) {
+            burst.push_back(OutgoingMessage{to, payload, 0});
+        }
+    }
+    for (auto _ : state) {
+        for (NodeId from : ids) {
+            if (state.range(1) == 1) {
+                network.send_batch(from, burst.data(), burst.size());
+                continue;
+            }
+            for (const auto& message : burst) {
+                network.send_message(from, message.to_id, message.content);
+            }
+        }
+        scheduler->run_for(200);  // Past every delivery time
+        
+        state.PauseTiming();
+        for (auto& node : nodes) {
+            node->process_message_queue();
+        }
+        state.ResumeTiming();
+    }
+    auto stats = network.get_stats();
+    state.counters["messages_per_handoff"] = stats.delivery_batches > 0
+        ? static_cast<double>(stats.delivered_messages) / stats.delivery_batches : 0.0;
+    state.SetItemsProcessed(state.iterations() * ids.size() * burst.size());
+}
+BENCHMARK(BM_NetworkAllToAllBurst)->ArgsProduct({{10, 50, 200}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
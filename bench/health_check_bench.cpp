@@ -0,0 +1,63 @@
+// Per-tick cost of the master's health check at 10k workers: a full
+// membership scan versus popping only the expired entries off a DeadlineIndex.
+#include "deadline_index.hpp"
+#include "membership_table.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+constexpr int64_t tick_ms = 100;
+constexpr int64_t timeout_ms = 3000;
+constexpr int ticks = 1000;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void heartbeat(NodeId id, int64_t now, MembershipTable& table, DeadlineIndex* index) {
+    table.mark_seen(id, now);
+    if (index) {
+        index->set(id, now + timeout_ms);
+    }
+}
+}
+
+int main(int argc, char** argv) {
+    NodeId workers = (argc > 1) ? static_cast<NodeId>(std::strtoul(argv[1], nullptr, 10)) : 10000;
+
+    MembershipTable scan_table;
+    MembershipTable index_table;
+    DeadlineIndex index;
+    for (NodeId id = 1; id <= workers; ++id) {
+        scan_table.add(id, 0);
+        index_table.add(id, 0);
+        index.set(id, timeout_ms);
+    }
+
+    double scan_ms = 0;
+    double index_ms = 0;
+    int scan_failed = 0;
+    int index_failed = 0;
+    for (int tick = 1; tick <= ticks; ++tick) {
+        int64_t now = tick * tick_ms;
+        // Every worker heartbeats once per second, staggered so a tenth arrive each tick
+        for (NodeId id = 1 + tick % 10; id <= workers; id += 10) {
+            heartbeat(id, now, scan_table, nullptr);
+            heartbeat(id, now, index_table, &index);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        scan_failed += scan_table.expire_stale(0, now, timeout_ms);
+        scan_ms += elapsed_ms(start);
+
+        start = std::chrono::steady_clock::now();
+        index_failed += static_cast<int>(index.pop_expired(now, [&](NodeId id) { index_table.set_alive(id, false); }));
+        index_ms += elapsed_ms(start);
+    }
+
+    std::cout << workers << " workers, " << ticks << " health checks\n"
+              << "full scan       " << (scan_ms * 1000 / ticks) << " us/tick, " << scan_failed << " failed\n"
+              << "deadline index  " << (index_ms * 1000 / ticks) << " us/tick, " << index_failed << " failed\n";
+    return 0;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "membership_observer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Ground-truth oracle for failure detector quality. The simulator reports
+// the crashes and recoveries it injects, every node reports each change of
+// its failed set, and detection latency plus the accuracy metrics of the
+// Chen/Toueg/Aguilera QoS model are kept up to date as events arrive.
+// Times are milliseconds on the simulation clock. Thread-safe: nodes report
+// from their own threads in wall-clock mode.
+class AccuracyOracle : public MembershipObserver {
+public:
+    // One crash of one node, from the injection to its recovery
+    struct Detection {
+        NodeId subject;
+        int64_t crash_ms;
+        int64_t recover_ms;                 // -1 while still down
+        size_t observers;                   // Live observers expected to notice
+        std::vector<int64_t> latencies_ms;  // Crash to each observer's suspicion, in detection order
+    };
+
+    struct Report {
+        size_t crashes;
+        size_t detections;             // (crash, observer) pairs that suspected the crashed node
+        size_t missed;                 // False negatives: observers that had not suspected it by recovery or now
+        double first_detection_ms;     // Means over crashes of the first, median and last observer's latency;
+        double median_detection_ms;    // NaN when no crash got that far (not a 0 ms detection)
+        double last_detection_ms;      // Only crashes that every observer detected
+        size_t false_positives;        // Suspicions raised against a live node
+        double mistake_rate;           // False positives per observer/subject pair per second of uptime
+        double mean_mistake_ms;        // How long a false suspicion lasts
+        double mean_recurrence_ms;     // Time between consecutive false suspicions on one pair
+        double query_accuracy;         // Fraction of live pair-time in which the subject was not suspected
+        double mean_recovery_ms;       // Recovery to an observer clearing its suspicion
+    };
+
+private:
+    static constexpr size_t no_episode = static_cast<size_t>(-1);
+
+    struct Member {
+        bool observer;
+        bool up;
+        int64_t up_since;
+        size_t open_episode;  // Index into detections while down
+    };
+
+    struct Pair {
+        bool suspected = false;
+        int64_t wrong_since = -1;          // Start of the current suspicion of a live subject
+        bool false_positive = false;       // It began as a false suspicion, not as a stale one after recovery
+        int64_t last_false_positive = -1;  // For recurrence time
+        size_t detected_episode = no_episode;
+    };
+
+    mutable std::mutex mutex;
+    std::unordered_map<NodeId, Member> members;
+    std::unordered_map<uint64_t, Pair> pairs;  // observer << 32 | subject
+    std::vector<Detection> detections;
+    size_t observer_count = 0;
+
+    // Running totals since the window began
+    int64_t closed_uptime_ms = 0;      // Member uptime already weighted by its observer count
+    size_t false_positives = 0;
+    size_t closed_mistakes = 0;
+    int64_t closed_mistake_ms = 0;
+    int64_t wrong_ms = 0;              // All closed suspicions of live subjects, stale ones included
+    size_t recurrences = 0;
+    int64_t recurrence_ms = 0;
+    size_t recovery_clears = 0;
+    int64_t recovery_ms = 0;
+    size_t missed = 0;                 // From closed episodes
+    size_t pending = 0;                // Live observers yet to detect a node that is down
+
+    static uint64_t key(NodeId observer, NodeId subject) { return (uint64_t{observer} << 32) | subject; }
+    size_t observers_of(NodeId subject) const;
+    void close_wrong(Pair& pair, int64_t now_ms);
+
+public:
+    AccuracyOracle() = default;
+
+    // Forgets every member and result
+    void reset();
+    // Restarts the measurement window, keeping members and their current views
+    void begin_window(int64_t now_ms);
+    // Observers are the nodes whose views count (every node for gossip and
+    // SWIM, only the monitors for heartbeats); every member is a subject
+    void add_member(NodeId id, bool observer, int64_t now_ms);
+
+    // Ground truth from failure injection
+    void record_crash(NodeId id, int64_t now_ms);
+    void record_recovery(NodeId id, int64_t now_ms);
+    // An observer started or stopped considering subject failed
+    void on_view_change(NodeId observer, NodeId subject, bool suspected, int64_t now_ms) override;
+
+    // Live observers that have not yet detected a node that is currently down
+    size_t pending_detections() const;
+    Report report(int64_t now_ms) const;
+    std::vector<Detection> get_detections() const;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "simulator.hpp"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Runs many (scenario, cluster size, seed) combinations in parallel. Every job
+// gets its own virtual-time Simulator, and so its own Network and node set;
+// jobs share nothing but the process-wide NodeRegistry. Results are grouped
+// per (scenario, size) and summarized across seeds.
+class BatchRunner {
+public:
+    enum class Scenario {
+        SingleNodeFailure,
+        MultipleFailures,
+        NetworkPartition,
+        HighLoad,
+        Recovery
+    };
+
+    struct Job {
+        Scenario scenario;
+        int num_nodes;
+        uint64_t seed;
+    };
+
+    // Distribution of one metric across seeds
+    struct Summary {
+        size_t samples;
+        double mean;
+        double p50;
+        double p99;
+        double ci_low;    // 95% confidence interval of the mean
+        double ci_high;
+    };
+
+    struct Aggregate {
+        Scenario scenario;
+        int num_nodes;
+        Summary detection_time_ms;  // Over the seeds where someone detected a crash
+        Summary messages_sent;
+        Summary accuracy;
+    };
+
+private:
+    size_t num_threads;
+
+    static Simulator::TestResult run_job(const Job& job);
+
+public:
+    explicit BatchRunner(size_t threads = std::thread::hardware_concurrency());
+
+    // Seeds base_seed .. base_seed + seeds - 1 for every scenario and size
+    std::vector<Aggregate> run(const std::vector<Scenario>& scenarios, const std::vector<int>& sizes,
+                               int seeds, uint64_t base_seed = 1);
+    std::vector<Simulator::TestResult> run_jobs(const std::vector<Job>& jobs);
+    // Any self-contained runs (each should build its own Simulator); results keep task order
+    std::vector<Simulator::TestResult> run_tasks(const std::vector<std::function<Simulator::TestResult()>>& tasks);
+
+    static Summary summarize(std::vector<double> samples);
+    static const char* scenario_name(Scenario scenario);
+    static void print(const std::vector<Aggregate>& aggregates);
+};
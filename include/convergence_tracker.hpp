@@ -0,0 +1,56 @@
+#pragma once
+
+#include "membership_observer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+// Incremental agreement tracker fed by view-change events. For every subject
+// it keeps how many live observers currently suspect it, so the moment the
+// first observer suspects a node and the moment all of them do are stamped
+// exactly, and "has the cluster converged" is a counter check rather than a
+// scan of every node's failed set.
+class ConvergenceTracker : public MembershipObserver {
+private:
+    struct Subject {
+        bool observer;
+        bool up;
+        size_t suspected_by = 0;        // Live observers suspecting it
+        int64_t first_suspected_ms = -1;  // When suspected_by last rose from zero
+        int64_t agreed_ms = -1;           // When every live observer last came to suspect it
+    };
+
+    mutable std::mutex mutex;
+    std::unordered_map<NodeId, Subject> subjects;
+    std::unordered_map<NodeId, std::unordered_set<NodeId>> suspicions;  // Observer -> subjects it suspects
+    size_t live_observers = 0;
+    size_t split_subjects = 0;   // Some but not all live observers suspect them
+    int64_t converged_ms = 0;    // When split_subjects last dropped to zero
+
+    size_t expected(const Subject& subject) const;  // Live observers other than the subject itself
+    bool is_split(const Subject& subject) const;
+    // Applies a change to one subject's count, keeping split_subjects and the timestamps current
+    void adjust(Subject& subject, int delta, int64_t now_ms);
+    // Observer liveness changes move every subject's target count
+    void recount(int64_t now_ms);
+
+public:
+    ConvergenceTracker() = default;
+
+    void reset(int64_t now_ms);
+    void add_member(NodeId id, bool observer, int64_t now_ms);
+    // Crashed observers' frozen views stop counting until they recover
+    void record_crash(NodeId id, int64_t now_ms);
+    void record_recovery(NodeId id, int64_t now_ms);
+    void on_view_change(NodeId observer, NodeId subject, bool suspected, int64_t now_ms) override;
+
+    // Every subject is suspected by either none or all of the live observers
+    bool is_converged() const;
+    int64_t get_converged_ms() const;
+    // -1 while nobody (or not everybody) suspects id
+    int64_t get_first_suspected_ms(NodeId id) const;
+    int64_t get_agreed_ms(NodeId id) const;
+    size_t get_suspected_by(NodeId id) const;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "node_registry.hpp"
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Indexed binary min-heap of per-node deadlines. positions maps each NodeId to
+// its heap slot, so a heartbeat moves its node's deadline in O(log N) and an
+// expiry check only touches the nodes whose deadline has actually passed.
+class DeadlineIndex {
+private:
+    struct Entry {
+        int64_t deadline;
+        NodeId id;
+    };
+
+    static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+    std::vector<Entry> heap;
+    std::vector<uint32_t> positions;  // Indexed by NodeId, npos when absent
+
+    void sift_up(size_t slot);
+    void sift_down(size_t slot);
+    void place(size_t slot, const Entry& entry);
+    void erase_slot(size_t slot);
+
+public:
+    // Inserts the node or moves its existing deadline
+    void set(NodeId id, int64_t deadline);
+    bool remove(NodeId id);
+    void clear();
+
+    bool contains(NodeId id) const { return id < positions.size() && positions[id] != npos; }
+    size_t size() const { return heap.size(); }
+    bool empty() const { return heap.empty(); }
+    int64_t get_deadline(NodeId id) const { return heap[positions[id]].deadline; }
+    int64_t next_deadline() const {
+        return heap.empty() ? std::numeric_limits<int64_t>::max() : heap[0].deadline;
+    }
+
+    // Removes every node whose deadline is before now_ms, earliest first
+    template <typename Callback>
+    size_t pop_expired(int64_t now_ms, Callback&& callback) {
+        size_t expired = 0;
+        while (!heap.empty() && heap[0].deadline < now_ms) {
+            NodeId id = heap[0].id;
+            erase_slot(0);
+            callback(id);
+            expired++;
+        }
+        return expired;
+    }
+};
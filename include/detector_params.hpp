@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+// Detector timing knobs, set per run by the simulator, scenario scripts and
+// the tuner. The defaults are the values the detectors were designed around.
+struct DetectorParams {
+    int gossip_interval_ms = 1000;     // Time between gossip rounds
+    int suspicion_threshold = 3;       // Missed gossip rounds before a member is failed
+    int fanout = 3;                    // Gossip targets per round
+    int heartbeat_interval_ms = 1000;  // Time between worker heartbeats
+    int failure_threshold_ms = 3000;   // Heartbeat silence before a worker is failed
+
+    // Name-based access for scenario files; nullptr for unknown names
+    int* field(const std::string& name) {
+        if (name == "gossip_interval_ms") return &gossip_interval_ms;
+        if (name == "suspicion_threshold") return &suspicion_threshold;
+        if (name == "fanout") return &fanout;
+        if (name == "heartbeat_interval_ms") return &heartbeat_interval_ms;
+        if (name == "failure_threshold_ms") return &failure_threshold_ms;
+        return nullptr;
+    }
+    int get(const std::string& name) const {
+        int* value = const_cast<DetectorParams*>(this)->field(name);
+        return value ? *value : 0;
+    }
+};
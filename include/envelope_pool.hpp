@@ -0,0 +1,62 @@
+#pragma once
+
+#include "node_registry.hpp"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One message on its way through the network and into a node's inbox. The
+// same envelope is moved by pointer through every stage and its content
+// buffer keeps its capacity across reuse, so steady-state sends do not allocate.
+struct Envelope {
+    NodeId from_id;
+    NodeId to_id;
+    std::string content;
+    std::chrono::system_clock::time_point sent_time;      // Set by the network
+    std::chrono::system_clock::time_point delivery_time;  // Set by the network
+    std::chrono::system_clock::time_point timestamp;      // Set by the receiving node
+    Envelope* next;                                       // Intrusive link (free lists, inbox)
+    Envelope* bundled;                                    // In flight: later messages coalesced into this one
+};
+
+// Process-wide envelope pool. Envelopes are carved from slabs that live until
+// exit; each thread keeps a private free list and only touches the shared list
+// (under a mutex) to refill or spill a batch, which handles the usual pattern
+// of envelopes acquired on the sending thread and released on the receiver's.
+class EnvelopePool {
+private:
+    static constexpr size_t slab_size = 256;
+    static constexpr size_t transfer_batch = 64;    // Envelopes moved per refill / spill
+    static constexpr size_t local_limit = 256;      // Spill once a thread caches more than this
+    static constexpr size_t initial_content_bytes = 256;  // Reserved per envelope when its slab is carved
+
+    struct LocalCache {
+        Envelope* head = nullptr;
+        size_t count = 0;
+        ~LocalCache();
+    };
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Envelope[]>> slabs;
+    Envelope* shared_head = nullptr;
+    size_t shared_count = 0;
+    uint64_t slab_allocations = 0;
+
+    EnvelopePool() = default;
+    static LocalCache& local_cache();
+    void refill(LocalCache& cache, uint64_t& allocations);
+    void spill(LocalCache& cache, size_t keep);
+
+public:
+    static EnvelopePool& instance();
+
+    // allocations is incremented for every heap allocation the call makes
+    Envelope* acquire(uint64_t& allocations);
+    void release(Envelope* envelope);
+
+    uint64_t get_slab_allocations();
+    size_t get_capacity();  // Envelopes carved so far
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "task_scheduler.hpp"
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+// Discrete-event scheduler driving a virtual clock. Events run in timestamp
+// order (FIFO for equal timestamps) and the clock jumps straight to the next
+// event, so simulated seconds cost only the CPU time of the events themselves.
+class EventScheduler : public TaskScheduler {
+private:
+    struct Event {
+        TimePoint time;
+        uint64_t seq;
+        Callback callback;
+
+        bool operator<(const Event& other) const {
+            if (time != other.time) {
+                return time > other.time;  // For min-heap priority queue
+            }
+            return seq > other.seq;
+        }
+    };
+
+    std::priority_queue<Event> events;
+    mutable std::mutex events_mutex;
+    TimePoint current_time;
+    uint64_t next_seq;
+    uint64_t executed_events;
+
+    bool pop_due_event(TimePoint deadline, Event& out);
+
+public:
+    explicit EventScheduler(TimePoint start_time = TimePoint{});
+    ~EventScheduler() override = default;
+
+    // Clock
+    TimePoint now() const override;
+
+    // Scheduling
+    void schedule_at(TimePoint when, Callback callback) override;
+
+    // Execution
+    bool run_next();
+    void run_until(TimePoint deadline);
+    void run_for(int duration_ms);
+    void clear();
+
+    // Introspection
+    size_t pending_events() const;
+    uint64_t get_executed_events() const;
+};
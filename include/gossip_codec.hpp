@@ -0,0 +1,77 @@
+#pragma once
+
+#include "node_registry.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Binary gossip wire format (version 3):
+//   header: magic 'G', format version byte
+//   entry:  NodeId as 4 little-endian bytes, flags byte (bit 0 = alive),
+//           varint entry version (the origin's heartbeat counter)
+// Entries repeat until the end of the buffer. Decoding reads straight from
+// the input view and never allocates.
+struct GossipEntry {
+    NodeId id;
+    bool is_alive;
+    uint64_t version;
+};
+
+class GossipEncoder {
+private:
+    std::string& out;
+
+public:
+    static constexpr uint8_t magic = 'G';
+    static constexpr uint8_t format_version = 3;
+    static constexpr size_t header_size = 2;
+    static constexpr size_t id_size = 4;
+
+    // Clears (but keeps the capacity of) the buffer and writes the header
+    explicit GossipEncoder(std::string& buffer);
+
+    void add(const GossipEntry& entry);
+
+    // Bytes add() would append for this entry
+    static size_t encoded_size(const GossipEntry& entry);
+};
+
+class GossipDecoder {
+private:
+    std::string_view data;
+    size_t pos;
+    bool error;
+
+public:
+    explicit GossipDecoder(std::string_view buffer);
+
+    // Returns false at the end of the buffer or on malformed input
+    bool next(GossipEntry& entry);
+    bool has_error() const { return error; }
+};
+
+// Anti-entropy wire format (version 1), used instead of full-state pushes when
+// GossipNode's anti-entropy mode is on (see merkle_digest.hpp):
+//   header:   magic 'M', kind byte
+//   Root:     varint level of the sender's root, 8-byte hash
+//   Children: varint level of the children, then per parent: varint parent
+//             index, 2-byte mask of non-empty children, 8-byte hash per set bit
+//   Entries:  flags byte (bit 0 = reply with your entries for these leaves),
+//             varint leaf count, varint leaf indices, then a complete gossip
+//             message (header included) with the sender's entries in them
+// Integers are little-endian.
+enum class AntiEntropyKind : uint8_t {
+    Root = 0,
+    Children = 1,
+    Entries = 2
+};
+constexpr uint8_t anti_entropy_magic = 'M';
+constexpr size_t anti_entropy_header_size = 2;
+
+// Varint helpers shared by the encoder and decoder
+void put_varint(std::string& out, uint64_t value);
+bool get_varint(std::string_view in, size_t& pos, uint64_t& value);
+size_t varint_size(uint64_t value);
+// Fixed-width little-endian helpers for hashes and masks
+void put_fixed(std::string& out, uint64_t value, size_t bytes);
+bool get_fixed(std::string_view in, size_t& pos, uint64_t& value, size_t bytes);
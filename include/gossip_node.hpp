@@ -1,28 +1,54 @@
 #pragma once
 
 #include "node.hpp"
+#include "membership_table.hpp"
+#include "merkle_digest.hpp"
+#include "peer_sampler.hpp"
 #include <unordered_map>
 #include <random>
+#include <string_view>
 
 class GossipNode : public Node {
 private:
-    // Node state tracking
-    struct NodeState {
-        bool is_alive;
-        std::chrono::system_clock::time_point last_seen;
-        int suspicion_level;
-    };
-    std::unordered_map<std::string, NodeState> node_states;
+    // Node state tracking: liveness columns live in the table, gossip columns
+    // below are parallel arrays indexed by the same NodeId
+    MembershipTable members;
+    std::vector<uint64_t> versions;      // Origin's heartbeat counter: only moves forward, but every round
+    std::vector<uint64_t> updated_seqs;  // Local change sequence number when the entry last changed
+    std::vector<NodeId> learned_from;    // Peer that gave us the current version
     mutable std::mutex states_mutex;
+    uint64_t update_seq = 0;    // Bumped on every local table change, guarded by states_mutex
+    std::string gossip_buffer;  // Reused encode buffer for gossip rounds
+
+    // Incremental gossip: what each peer has already been sent, indexed by NodeId
+    struct PeerSync {
+        bool known;              // Have we sent this peer anything yet
+        uint64_t last_sent_seq;  // update_seq at the last message to this peer
+        int deltas_since_full;   // Deltas sent since the last full-state message
+    };
+    std::vector<PeerSync> peer_sync;  // Guarded by states_mutex
+    bool delta_gossip = false;
+
+    // Anti-entropy: peers swap a hash digest of their tables and transfer only
+    // the id ranges that differ. Heartbeat counters are hashed in blocks of
+    // epoch_rounds, so a live cluster only differs when a block turns over.
+    bool anti_entropy = false;
+    int epoch_rounds = 4;
+    MerkleDigest digest;                // Kept current entry by entry while anti_entropy is on
+    std::vector<uint64_t> entry_hashes; // Each member's hash in the digest (0 when absent), by NodeId
+    std::string entries_buffer;       // Reused gossip message embedded in Entries replies
 
-    // Gossip parameters
-    const int gossip_interval_ms = 1000;  // Time between gossip rounds
-    const int suspicion_threshold = 3;    // Number of missed rounds before marking as failed
-    const int fanout = 3;                 // Number of peers to gossip with each round
+    // Gossip parameters (see set_timing)
+    int gossip_interval_ms = 1000;        // Time between gossip rounds
+    int suspicion_threshold = 3;          // Number of missed rounds before marking as failed
+    int fanout = 3;                       // Number of peers to gossip with each round
+    const int full_sync_interval = 10;    // Deltas to a peer before a full-state resync
+    std::chrono::system_clock::time_point last_gossip;
     
-    // Random number generation for peer selection
+    // Peer selection: a cached peer array sampled in O(fanout), guarded by states_mutex
+    PeerSampler sampler;
+    std::vector<NodeId> round_peers;  // This round's picks, only touched by gossip_round
     std::mt19937 rng;
-    std::uniform_int_distribution<int> peer_dist;
 
     // Metrics
     struct Metrics {
@@ -34,16 +60,18 @@ private:
     } metrics;
 
 public:
-    GossipNode(const std::string& node_id, const std::vector<std::string>& peer_ids);
+    GossipNode(const std::string& node_id, const std::vector<std::string>& peer_ids,
+               std::shared_ptr<TaskScheduler> task_scheduler = nullptr);
     ~GossipNode() override = default;
 
     // Core functionality
-    void start() override;
     void send_message(const std::string& to_id, const std::string& content) override;
     void process_message(const Message& msg) override;
 
     // State management
     std::vector<std::string> get_failed_nodes() const;
+    std::vector<NodeId> get_failed_node_ids() const override;
+    bool is_node_failed(NodeId node_id) const override;
     void add_peer(const std::string& peer_id);
     void remove_peer(const std::string& peer_id);
 
@@ -51,15 +79,53 @@ public:
     Metrics get_metrics() const;
     void reset_metrics();
 
+    // Round length, missed rounds before suspicion and targets per round; call before start()
+    void set_timing(int interval_ms, int missed_rounds, int peers_per_round);
+
+    // Incremental mode: send only entries changed since the last message to each peer.
+    // Versions are heartbeat counters, so with random peers most of the table has moved
+    // between two messages to the same peer: what it saves is entries learned from that
+    // peer and members that stopped beating, a share that shrinks as the cluster grows.
+    // Deltas therefore grow with N, not with churn: relayed heartbeats are the only
+    // liveness evidence for members a node does not hear from directly. Anti-entropy
+    // is the mode that gives up detection latency for smaller messages
+    void set_delta_gossip(bool enabled) { delta_gossip = enabled; }
+    bool is_delta_gossip() const { return delta_gossip; }
+
+    // Digest exchange instead of full-state pushes. Suspicion waits an extra
+    // epoch_rounds rounds, since a live member's counter is only guaranteed to
+    // be resent when its block turns over.
+    void set_anti_entropy(bool enabled, int rounds_per_epoch = 4);
+    bool is_anti_entropy() const { return anti_entropy; }
+
+    // How gossip targets are picked each round (see peer_sampler.hpp); zones
+    // only matter to ZoneAware, and every member starts in zone 0
+    void set_peer_sampling(PeerSampler::Strategy strategy);
+    void set_zone(NodeId member, int zone);
+
+    // Makes peer selection reproducible
+    void set_seed(uint64_t seed) { rng.seed(static_cast<std::mt19937::result_type>(seed)); }
+
+    // Wire format (see gossip_codec.hpp)
+    void serialize_state(std::string& out) const;
+    size_t serialize_delta(NodeId peer_id, std::string& out);
+    void deserialize_state(std::string_view in, NodeId from_id = invalid_node_id);
+
 protected:
     void periodic_task() override;
 
 private:
     // Helper functions
     void gossip_round();
-    std::vector<std::string> select_random_peers();
-    void update_node_state(const std::string& node_id, bool is_alive);
-    bool is_node_failed(const std::string& node_id) const;
-    void serialize_state(std::string& out) const;
-    void deserialize_state(const std::string& in);
-}; 
\ No newline at end of file
+    const std::vector<NodeId>& select_peers();
+    void add_member(NodeId member_id);
+    void update_node_state(NodeId node_id, bool is_alive);
+
+    // Anti-entropy helpers; the encoders expect states_mutex to be held
+    void rebuild_digest();
+    void refresh_entry(NodeId member);  // Swaps one entry's hash after its epoch or liveness changed
+    void encode_root(std::string& out);
+    void encode_children(std::string& out, int child_level, const std::vector<size_t>& parents);
+    void encode_entries(std::string& out, bool reply_wanted, const std::vector<size_t>& leaves);
+    void handle_anti_entropy(std::string_view in, NodeId from_id);
+};
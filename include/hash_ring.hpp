@@ -0,0 +1,31 @@
+#pragma once
+
+#include "node_registry.hpp"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Consistent-hash ring assigning monitored nodes to monitors. Each monitor is
+// placed at virtual_nodes pseudo-random points so shards stay balanced, and
+// removing a monitor only moves the keys it owned to its ring successors.
+class HashRing {
+private:
+    std::vector<std::pair<uint64_t, NodeId>> points;  // Sorted by hash
+    std::vector<NodeId> monitors;
+    size_t virtual_nodes;
+
+    static uint64_t hash(uint64_t value);
+
+public:
+    explicit HashRing(size_t virtual_nodes = 64);
+
+    void add(NodeId monitor);
+    void remove(NodeId monitor);
+    bool contains(NodeId monitor) const;
+    size_t size() const { return monitors.size(); }
+    const std::vector<NodeId>& get_monitors() const { return monitors; }
+
+    // First count distinct monitors clockwise from the key, skipping excluded ones
+    std::vector<NodeId> owners(NodeId key, size_t count, const std::vector<NodeId>& excluded = {}) const;
+    NodeId owner(NodeId key) const;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// HDR-style log-linear histogram: values below 32 get their own bucket, above
+// that every power of two is split into 16 buckets, so any recorded value is
+// reported within ~6% using 464 buckets for the whole uint32 range (larger
+// values share the last bucket).
+// This is the plain snapshot form: one owner, cheap to copy and merge.
+class HdrHistogram {
+public:
+    static constexpr int sub_bucket_bits = 4;  // 16 buckets per power of two
+    static constexpr size_t bucket_count = 32 + (32 - sub_bucket_bits - 1) * 16;
+
+    static size_t index_of(uint64_t value);
+    static uint64_t lowest_value(size_t index);   // Smallest value mapping to index
+    static uint64_t highest_value(size_t index);  // Largest value mapping to index
+
+private:
+    std::vector<uint64_t> counts;  // Grows to the highest bucket used
+    uint64_t total;
+    uint64_t min_value;
+    uint64_t max_value;
+    long double sum;
+
+    friend class StripedHistogram;  // Sets the exact extremes after merging stripes
+
+public:
+    HdrHistogram();
+
+    void record(uint64_t value, uint64_t count = 1);
+    void record_bucket(size_t index, uint64_t count);  // Used when merging striped counters
+    void merge(const HdrHistogram& other);
+    void reset();
+
+    uint64_t get_count() const { return total; }
+    uint64_t get_min() const { return total ? min_value : 0; }
+    uint64_t get_max() const { return max_value; }
+    double get_mean() const { return total ? static_cast<double>(sum / total) : 0.0; }
+    // Upper bound of the bucket holding the p-th percentile (p in [0, 100]), clamped to max
+    uint64_t value_at_percentile(double percentile) const;
+};
+
+// Concurrent recorder: a handful of stripes of relaxed atomic counters. Each
+// thread sticks to one stripe, so recording is a single uncontended fetch_add
+// in the common case and never takes a lock; snapshot() merges the stripes.
+class StripedHistogram {
+private:
+    static constexpr size_t stripes = 4;
+
+    struct alignas(64) Stripe {
+        std::array<std::atomic<uint64_t>, HdrHistogram::bucket_count> counts;
+        std::atomic<uint64_t> min_value;
+        std::atomic<uint64_t> max_value;
+    };
+    std::array<Stripe, stripes> data;
+
+    static size_t stripe_index();
+
+public:
+    StripedHistogram();
+
+    void record(uint64_t value);
+    HdrHistogram snapshot() const;
+    void reset();
+};
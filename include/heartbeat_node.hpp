@@ -1,47 +1,89 @@
 #pragma once
 
 #include "node.hpp"
-#include <unordered_map>
+#include "membership_table.hpp"
+#include "phi_accrual_detector.hpp"
+#include "hash_ring.hpp"
+#include "deadline_index.hpp"
 #include <chrono>
 
 class HeartbeatNode : public Node {
-private:
-    // Node state tracking
-    struct NodeState {
-        bool is_alive;
-        std::chrono::system_clock::time_point last_heartbeat;
+public:
+    enum class DetectionMode {
+        FixedTimeout,   // Fail after failure_threshold_ms without a heartbeat
+        PhiAccrual      // Fail once the phi suspicion level crosses phi_threshold
     };
-    std::unordered_map<std::string, NodeState> node_states;
+
+private:
+    // Node state tracking (last_seen column holds the last heartbeat time)
+    MembershipTable members;
     mutable std::mutex states_mutex;
 
-    // Heartbeat parameters
-    const int heartbeat_interval_ms = 1000;    // Time between heartbeats
-    const int failure_threshold_ms = 3000;     // Time without heartbeat before marking as failed
+    // Heartbeat parameters (see set_timing)
+    int heartbeat_interval_ms = 1000;          // Time between heartbeats
+    int failure_threshold_ms = 3000;           // Time without heartbeat before marking as failed
     bool is_master;                            // Whether this node is the master node
+    std::string master_id = "master";          // Where workers send their heartbeats
+    DetectionMode detection_mode = DetectionMode::FixedTimeout;
+    double phi_threshold = 8.0;
+    PhiAccrualDetector phi_detector;           // Guarded by states_mutex; tolerates one lost heartbeat
+    DeadlineIndex deadlines;                   // When each live worker fails under the current mode
+
+    // Sharded monitoring: workers report only to their owners on the ring, and
+    // monitors ack so workers can route around a dead monitor
+    std::shared_ptr<const HashRing> monitor_ring;
+    size_t monitor_replicas = 1;
+    int monitor_timeout_ms = 6000;             // No acks for this long: owner is dead, pick the next one
+    std::vector<NodeId> failed_monitors;       // Worker-side exclusions from the ring
+    std::vector<int64_t> monitor_retry_ms;     // Parallel to failed_monitors: next probe
+    std::vector<NodeId> released_monitors;     // Former owners told to stop watching us until they confirm
+    std::vector<NodeId> owners;                // Current owners, recomputed when exclusions change
+    std::vector<int64_t> owner_last_ack_ms;    // Parallel to owners
+    std::chrono::system_clock::time_point last_heartbeat;
 
     // Metrics
     struct Metrics {
         int heartbeats_sent;
         int heartbeats_received;
-        int false_positives;
-        int false_negatives;
+        int suspicions;         // Timeouts raised; whether they were right is the simulator oracle's call
+        int monitor_failovers;
         std::chrono::system_clock::time_point last_metrics_reset;
     } metrics;
 
 public:
-    HeartbeatNode(const std::string& node_id, bool is_master_node);
+    HeartbeatNode(const std::string& node_id, bool is_master_node,
+                  std::shared_ptr<TaskScheduler> task_scheduler = nullptr);
     ~HeartbeatNode() override = default;
 
     // Core functionality
-    void start() override;
     void send_message(const std::string& to_id, const std::string& content) override;
     void process_message(const Message& msg) override;
 
     // State management
     std::vector<std::string> get_failed_nodes() const;
+    std::vector<NodeId> get_failed_node_ids() const override;
+    bool is_node_failed(NodeId node_id) const override;
     void add_node(const std::string& node_id);
     void remove_node(const std::string& node_id);
     bool is_master_node() const { return is_master; }
+    void set_master(const std::string& node_id) { master_id = node_id; }
+
+    // Multi-master mode: masters in the ring ack heartbeats, workers send to
+    // their replicas owners instead of master_id
+    void set_monitor_ring(std::shared_ptr<const HashRing> ring, size_t replicas = 1);
+    std::vector<NodeId> get_owners() const;
+    size_t get_monitored_count() const;
+
+    // Heartbeat period and fixed timeout; restarts the phi windows, so call before start().
+    // Workers give up on a silent monitor after twice the timeout
+    void set_timing(int interval_ms, int timeout_ms);
+
+    // Failure detection policy
+    void set_detection_mode(DetectionMode mode);
+    DetectionMode get_detection_mode() const { return detection_mode; }
+    void set_phi_threshold(double threshold);
+    double get_phi_threshold() const { return phi_threshold; }
+    double get_phi(NodeId node_id) const;
 
     // Metrics
     Metrics get_metrics() const;
@@ -53,7 +95,12 @@ protected:
 private:
     // Helper functions
     void send_heartbeat();
+    void check_owners();
+    void assign_owners();
+    void readmit_monitor(NodeId monitor);  // Callers hold states_mutex
     void check_node_health();
-    void update_node_state(const std::string& node_id, bool is_alive);
-    bool is_node_failed(const std::string& node_id) const;
+    void refresh_deadline(NodeId node_id);  // Callers hold states_mutex
+    void rebuild_deadlines();
+    void update_node_state(NodeId node_id, bool is_alive);
+    void forget_worker(NodeId node_id);  // A worker that moved to another owner
 }; 
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "node_registry.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Loss, delay and bandwidth of one directed link
+struct LinkParams {
+    double loss_rate = 0.1;
+    double mean_delay_ms = 50.0;
+    double std_dev_delay_ms = 10.0;
+    double bandwidth_bytes_per_s = 0.0;  // 0: unlimited
+};
+
+// Per-link network model. Nodes belong to a group (rack, zone, DC); each
+// directed group pair has its own LinkParams, and single node pairs can
+// override them. Faults never touch a hash table on the send path: group
+// cuts are one bit in a 64x64 bit matrix, ad-hoc partitions one AND of two
+// per-node side masks.
+//
+// Every LinkParams entry with a bandwidth cap is one shared pipe: all the
+// node pairs it covers queue behind each other, like a rack uplink.
+//
+// Topology files are line based, '#' starts a comment:
+//   default [options]                    defaults for pairs without a link line
+//   group NAME NODE...                   assigns nodes to a group (max 63 groups)
+//   link FROM TO [options] [oneway]      group pair, both directions unless oneway
+//   node-link FROM TO [options] [oneway] node pair override
+//   partition A B [oneway]               cuts A -> B (and B -> A unless oneway)
+// with options: delay MEAN_MS [STDDEV_MS], loss RATE, bandwidth BYTES_PER_S.
+// Options not given on a line are taken from the defaults at that point.
+//
+// Not thread safe to change. Network routes through a snapshot that is never
+// changed again once published; only reserve() writes, to the pipe clocks.
+class LinkModel {
+public:
+    static constexpr size_t max_groups = 64;
+
+private:
+    LinkParams defaults;
+    std::vector<std::string> group_names;        // Group 0 is "default", every unassigned node's
+    std::vector<uint8_t> group_of;               // Indexed by NodeId
+    std::vector<uint32_t> pair_links;            // from_group * max_groups + to_group -> links index
+    std::unordered_map<uint64_t, uint32_t> node_links;  // from << 32 | to -> links index
+    std::vector<LinkParams> links;               // [0] is the defaults
+    mutable std::vector<double> busy_until_ms;   // Parallel to links: when each pipe frees up
+    std::array<uint64_t, max_groups> cut_groups; // Bit t of row f: group f cannot reach group t
+    std::vector<uint8_t> sides;                  // Indexed by NodeId; nodes talk when masks overlap
+    bool split = false;
+
+    uint32_t add_link(const LinkParams& params);
+
+public:
+    LinkModel();
+
+    // Back to one group, default parameters and no faults
+    void clear();
+    bool load(const std::string& file_path, std::string& error);
+    bool parse(std::istream& in, std::string& error);
+    // The option words of one line (delay/loss/bandwidth/oneway) on top of params
+    static bool parse_options(std::istream& in, LinkParams& params, bool& one_way, std::string& error);
+
+    void set_defaults(const LinkParams& params);
+    const LinkParams& get_defaults() const { return defaults; }
+    int find_group(const std::string& name) const;  // -1 if unknown
+    int add_group(const std::string& name);         // Existing id, or -1 past max_groups
+    void assign(NodeId node, int group);
+    int group_of_node(NodeId node) const { return node < group_of.size() ? group_of[node] : 0; }
+    void set_group_link(int from_group, int to_group, const LinkParams& params);
+    void set_node_link(NodeId from, NodeId to, const LinkParams& params);
+
+    // Group cuts stay until heal_groups; one_way keeps to -> from open
+    void cut(int from_group, int to_group, bool one_way = false);
+    void heal_groups();
+    // Ad-hoc partition: members of different sides stop talking, nodes in neither
+    // still reach both. Replaces the previous one; independent of group cuts
+    void split_sides(const std::vector<NodeId>& side_a, const std::vector<NodeId>& side_b);
+    void heal_sides();
+
+    bool is_blocked(NodeId from, NodeId to) const {
+        size_t from_group = group_of_node(from);
+        size_t to_group = group_of_node(to);
+        if ((cut_groups[from_group] >> to_group) & 1) {
+            return true;
+        }
+        return split && from < sides.size() && to < sides.size() && (sides[from] & sides[to]) == 0;
+    }
+    size_t link_index(NodeId from, NodeId to) const {
+        if (!node_links.empty()) {
+            auto it = node_links.find((uint64_t{from} << 32) | to);
+            if (it != node_links.end()) {
+                return it->second;
+            }
+        }
+        return pair_links[group_of_node(from) * max_groups + group_of_node(to)];
+    }
+    const LinkParams& get_link(size_t index) const { return links[index]; }
+    // Queues bytes on a capped link and returns the extra delay until they are on the wire;
+    // callers serialize it, and copying the model, against each other
+    double reserve(size_t index, size_t bytes, double now_ms) const;
+};
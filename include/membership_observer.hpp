@@ -0,0 +1,29 @@
+#pragma once
+
+#include "node_registry.hpp"
+#include <cstdint>
+#include <vector>
+
+// Receives every flip of one node's view of another member, at the moment
+// the detector makes it. Called with the detector's state lock held, so
+// implementations must not call back into the node.
+class MembershipObserver {
+public:
+    virtual ~MembershipObserver() = default;
+    virtual void on_view_change(NodeId observer, NodeId subject, bool suspected, int64_t now_ms) = 0;
+};
+
+// Forwards each change to several observers (nodes hold a single pointer)
+class MembershipFanout : public MembershipObserver {
+private:
+    std::vector<MembershipObserver*> targets;
+
+public:
+    explicit MembershipFanout(std::vector<MembershipObserver*> observers) : targets(std::move(observers)) {}
+
+    void on_view_change(NodeId observer, NodeId subject, bool suspected, int64_t now_ms) override {
+        for (MembershipObserver* target : targets) {
+            target->on_view_change(observer, subject, suspected, now_ms);
+        }
+    }
+};
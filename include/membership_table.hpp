@@ -0,0 +1,61 @@
+#pragma once
+
+#include "node_registry.hpp"
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+// Struct-of-arrays membership view indexed directly by NodeId. Each column is
+// a contiguous array, so health scans are linear passes with no hashing or
+// string compares. Absent ids simply have their presence bit cleared.
+class MembershipTable {
+private:
+    std::vector<NodeId> members;        // Present ids, for iteration and sampling
+    std::vector<uint8_t> present;
+    std::vector<uint8_t> alive;
+    std::vector<int64_t> last_seen_ms;  // Local clock ticks when last heard from
+    std::vector<int32_t> suspicion;
+    std::function<void(NodeId, bool)> on_flip;
+
+    // Every write to the alive column goes through here so flips reach the handler
+    void write_alive(NodeId id, uint8_t value) {
+        if (alive[id] != value) {
+            alive[id] = value;
+            if (on_flip) {
+                on_flip(id, value == 0);
+            }
+        }
+    }
+
+public:
+    // Called with (id, failed) whenever a member's alive bit flips, including
+    // a failed member being removed; the owner turns these into view-change events
+    void set_flip_handler(std::function<void(NodeId, bool)> handler) { on_flip = std::move(handler); }
+
+    // Returns true if the id was not already a member
+    bool add(NodeId id, int64_t now_ms);
+    bool remove(NodeId id);
+    bool contains(NodeId id) const { return id < present.size() && present[id]; }
+    size_t size() const { return members.size(); }
+    size_t capacity() const { return present.size(); }
+    const std::vector<NodeId>& get_members() const { return members; }
+
+    // Columns (callers must check contains() first)
+    bool is_alive(NodeId id) const { return alive[id] != 0; }
+    void set_alive(NodeId id, bool value) { write_alive(id, value ? 1 : 0); }
+    int64_t get_last_seen(NodeId id) const { return last_seen_ms[id]; }
+    int32_t get_suspicion(NodeId id) const { return suspicion[id]; }
+    void mark_seen(NodeId id, int64_t now_ms);
+
+    // Gossip-style aging: bump suspicion of every member (except self) not heard
+    // from within stale_after_ms, failing those that reach threshold
+    void advance_suspicion(NodeId self, int64_t now_ms, int64_t stale_after_ms, int32_t threshold);
+    // Heartbeat-style expiry: fail members not heard from within timeout_ms.
+    // Returns how many members flipped from alive to failed.
+    int expire_stale(NodeId self, int64_t now_ms, int64_t timeout_ms);
+
+    // Members that are dead or at/over the suspicion threshold
+    std::vector<NodeId> collect_failed(
+        int32_t suspicion_threshold = std::numeric_limits<int32_t>::max()) const;
+};
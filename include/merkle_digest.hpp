@@ -0,0 +1,39 @@
+#pragma once
+
+#include "node_registry.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Hash tree over NodeId ranges for anti-entropy. Leaves cover 16 consecutive
+// ids and every level up covers 16 times more, so the shape depends only on
+// the ids and two tables can be compared level by level without agreeing on
+// membership first. A node's hash is the XOR of its entries' hashes: empty
+// ranges hash to 0 and a changed entry never needs a sorted rebuild.
+class MerkleDigest {
+public:
+    static constexpr int fanout_bits = 4;
+    static constexpr size_t fanout = size_t{1} << fanout_bits;
+
+private:
+    std::vector<std::vector<uint64_t>> levels;  // levels[0] are leaves; the last level has one node
+
+public:
+    // Index of the node covering id at level (leaves are level 0)
+    static size_t index_of(NodeId id, int level) {
+        return static_cast<size_t>(id) >> (fanout_bits * (level + 1));
+    }
+    static uint64_t entry_hash(NodeId id, bool alive, uint64_t epoch);
+
+    void clear();
+    void add(NodeId id, uint64_t hash);  // Leaves only; call build() after the last add
+    void build();
+    // XORs hash into id's leaf and every node above it, growing the tree as needed:
+    // toggling old ^ new swaps one entry in O(depth) without a rebuild
+    void toggle(NodeId id, uint64_t hash);
+
+    // Level of the root; every id added so far falls under its index 0
+    int get_depth() const { return levels.empty() ? 0 : static_cast<int>(levels.size()) - 1; }
+    // 0 for empty ranges; above the root, index 0 is the root itself
+    uint64_t get(int level, size_t index) const;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Lock-free multi-producer single-consumer inbox over intrusive items (T must
+// have a T* next member). Producers push onto a stack with a CAS on the head;
+// the consumer swaps the whole stack out in one exchange and reverses it, so
+// batches come back in FIFO order. Only the consumer ever detaches items, so
+// the push CAS is free of ABA. The inbox never allocates and never owns items:
+// whoever drains it takes them over, and the owner must drain it before it dies.
+template <typename T>
+class MpscInbox {
+private:
+    std::atomic<T*> head;
+    std::atomic<size_t> depth;
+
+public:
+    MpscInbox() : head(nullptr), depth(0) {}
+    MpscInbox(const MpscInbox&) = delete;
+    MpscInbox& operator=(const MpscInbox&) = delete;
+
+    // Producer side; returns the depth including the new item. The count goes
+    // up before the item is published, so a racing drain can leave it briefly
+    // high but never below zero
+    size_t push(T* item) {
+        size_t new_depth = depth.fetch_add(1, std::memory_order_relaxed) + 1;
+        item->next = head.load(std::memory_order_relaxed);
+        while (!head.compare_exchange_weak(item->next, item,
+                                           std::memory_order_release, std::memory_order_relaxed)) {
+        }
+        return new_depth;
+    }
+
+    // Producer side for several items at once, oldest first: links them
+    // and publishes the whole run with one CAS
+    size_t push_all(T* const* items, size_t count) {
+        if (count == 0) {
+            return size();
+        }
+        size_t new_depth = depth.fetch_add(count, std::memory_order_relaxed) + count;
+        for (size_t i = 1; i < count; ++i) {
+            items[i]->next = items[i - 1];
+        }
+        T* oldest = items[0];
+        oldest->next = head.load(std::memory_order_relaxed);
+        while (!head.compare_exchange_weak(oldest->next, items[count - 1],
+                                           std::memory_order_release, std::memory_order_relaxed)) {
+        }
+        return new_depth;
+    }
+
+    // Consumer side; must not run concurrently with itself. The callback takes
+    // ownership of each item. Returns the batch size.
+    template <typename Callback>
+    size_t drain(Callback&& callback) {
+        T* batch = head.exchange(nullptr, std::memory_order_acquire);
+        if (!batch) {
+            return 0;
+        }
+
+        // The stack holds newest first
+        T* ordered = nullptr;
+        size_t batch_size = 0;
+        while (batch) {
+            T* next = batch->next;
+            batch->next = ordered;
+            ordered = batch;
+            batch = next;
+            batch_size++;
+        }
+        depth.fetch_sub(batch_size, std::memory_order_relaxed);
+
+        while (ordered) {
+            T* next = ordered->next;
+            callback(ordered);
+            ordered = next;
+        }
+        return batch_size;
+    }
+
+    size_t size() const { return depth.load(std::memory_order_relaxed); }
+    bool empty() const { return head.load(std::memory_order_acquire) == nullptr; }
+};
@@ -6,76 +6,235 @@
 #include <mutex>
 #include <atomic>
 #include <random>
-#include <unordered_set>
 #include <unordered_map>
 #include <chrono>
 #include <memory>
+#include "task_scheduler.hpp"
+#include "node_registry.hpp"
+#include "timing_wheel.hpp"
+#include "envelope_pool.hpp"
+#include "transport.hpp"
+#include "trace_recorder.hpp"
+#include "hdr_histogram.hpp"
+#include "link_model.hpp"
+#include <array>
 
 class Node;  // Forward declaration
 
-class Network {
+// Simulated in-process transport; loss, delay, bandwidth and partitions come from a LinkModel
+class Network : public Transport {
+public:
+    // Structure holding in-flight messages until their delivery time
+    enum class DeliveryQueue {
+        Heap,         // One global priority_queue behind one mutex
+        TimingWheel   // Hierarchical timing wheels sharded by destination
+    };
+
+    // Latency is broken down by what the payload is, recognized from its header
+    enum class MessageType {
+        Gossip,        // Binary gossip codec ('G')
+        Heartbeat,
+        HeartbeatAck,
+        Swim,          // Binary SWIM codec ('S')
+        AntiEntropy,   // Merkle digests and range entries between gossip nodes ('M')
+        Other
+    };
+    static constexpr size_t message_type_count = 6;
+
+    // Microsecond histograms; delivery and queueing delays are on the
+    // simulation clock, processing time is wall clock
+    struct LatencyStats {
+        HdrHistogram delivery_delay_us;   // Send to hand-off into the receiver's inbox
+        HdrHistogram queueing_delay_us;   // Inbox to the start of the drain that processed it
+        HdrHistogram processing_us;       // process_message itself
+    };
+
+    struct LinkStats {
+        NodeId from_id;
+        NodeId to_id;
+        uint64_t sent;
+        uint64_t dropped;
+        uint64_t bytes;
+        HdrHistogram delivery_delay_us;
+    };
+
 private:
-    struct Message {
-        std::string from_id;
-        std::string to_id;
-        std::string content;
-        std::chrono::system_clock::time_point delivery_time;
-
-        bool operator<(const Message& other) const {
-            return delivery_time > other.delivery_time;  // For min-heap priority queue
+    // In-flight messages are pooled envelopes moved by pointer from send to inbox
+    struct LaterDelivery {
+        bool operator()(const Envelope* a, const Envelope* b) const {
+            return a->delivery_time > b->delivery_time;  // For min-heap priority queue
         }
     };
 
-    std::mt19937 rng;
-    std::uniform_real_distribution<double> loss_dist;
-    std::normal_distribution<double> delay_dist;
+    // When set, deliveries become scheduler tasks instead of being polled
+    std::shared_ptr<TaskScheduler> scheduler;
+
+    // Loss and delay draws hash (seed, sender, sequence) like ShardProcess, so
+    // senders never share a generator; the sequence counters are striped by sender
+    struct alignas(64) SendStream {
+        std::atomic<uint64_t> seq{0};
+    };
+    static constexpr size_t num_send_streams = 64;
+    std::array<SendStream, num_send_streams> send_streams;
+    std::atomic<uint64_t> seed;
+    std::mutex pipe_mutex;  // Bandwidth-capped links share their pipe clocks across senders
 
-    std::unordered_map<std::string, std::shared_ptr<Node>> nodes;
+    // Routing reads the current topology snapshot without a lock. A change copies it,
+    // edits the copy and publishes that; a sender may still be reading an older one,
+    // so snapshots live as long as the network (faults and loads are rare)
+    std::atomic<const LinkModel*> topology;
+    std::vector<std::unique_ptr<LinkModel>> topology_snapshots;
+    std::mutex topology_mutex;          // Serializes changes and guards partition_generation
+    uint64_t partition_generation = 0;  // Lets a timed heal skip partitions set up after it
+
+    std::atomic<TraceRecorder*> trace;  // Optional; records sends, drops and deliveries
+
+    std::vector<std::shared_ptr<Node>> nodes;  // Indexed by NodeId
     std::mutex nodes_mutex;
     
-    std::priority_queue<Message> message_queue;
+    DeliveryQueue delivery_queue;
+    std::priority_queue<Envelope*, std::vector<Envelope*>, LaterDelivery> message_queue;
     std::mutex queue_mutex;
 
-    // Network parameters
-    const double message_loss_rate = 0.1;  // 10% message loss rate
-    const double mean_delay = 50.0;        // Mean delay in milliseconds
-    const double std_dev_delay = 10.0;     // Standard deviation of delay
+    // Timing-wheel delivery: senders only lock the destination's shard
+    struct WheelShard {
+        std::mutex mutex;
+        TimingWheel<Envelope*> wheel;
+
+        explicit WheelShard(int64_t start_tick) : wheel(start_tick) {}
+    };
+    static constexpr size_t num_wheel_shards = 16;
+    std::vector<std::unique_ptr<WheelShard>> wheel_shards;
+
+    // Delivery times that already have a process_messages queued, slotted by
+    // millisecond tick; a collision only costs a redundant wake-up
+    static constexpr size_t num_wakeup_slots = 1024;
+    std::array<std::atomic<int64_t>, num_wakeup_slots> wakeups;
 
-    // Network partition simulation
-    std::unordered_map<std::string, std::unordered_set<std::string>> partitions;
-    std::mutex partition_mutex;
+    // Live recorders behind LatencyStats; recording never takes a lock
+    struct LatencyRecorders {
+        StripedHistogram delivery_delay_us;
+        StripedHistogram queueing_delay_us;
+        StripedHistogram processing_us;
+    };
+    std::array<LatencyRecorders, message_type_count> latency;
+
+    // Per-link counters, only kept when enabled (they grow with the links in use)
+    struct LinkShard {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, LinkStats> links;  // from_id << 32 | to_id
+    };
+    static constexpr size_t num_link_shards = 16;
+    std::atomic<bool> link_stats_enabled;
+    mutable std::array<LinkShard, num_link_shards> link_shards;
 
     struct NetworkStats {
         std::atomic<int> delivered_messages;
-        std::atomic<int> dropped_messages;
+        std::atomic<int> dropped_messages;   // Lost or blocked
+        std::atomic<int> blocked_messages;   // Dropped by a partition
         std::atomic<double> total_delay;
+        std::atomic<uint64_t> sent_bytes;    // Payload bytes handed to the network
+        std::atomic<uint64_t> saved_bytes;   // Bytes avoided by sending deltas instead of full state
+        std::atomic<uint64_t> allocations;   // Heap allocations on the send path (pool slabs, buffer growth)
+        std::atomic<uint64_t> coalesced_messages;  // Rode in another message's envelope (send_batch)
+        std::atomic<uint64_t> delivery_batches;    // Inbox hand-offs: one per destination per delivery round
 
-        NetworkStats() : delivered_messages(0), dropped_messages(0), total_delay(0.0) {}
+        // Filled in by get_stats only
+        std::array<LatencyStats, message_type_count> by_type;
+        LatencyStats overall;
+        std::vector<LinkStats> links;
+
+        NetworkStats() : delivered_messages(0), dropped_messages(0), blocked_messages(0), total_delay(0.0),
+                         sent_bytes(0), saved_bytes(0), allocations(0), coalesced_messages(0),
+                         delivery_batches(0) {}
         
         // Custom copy constructor
         NetworkStats(const NetworkStats& other) 
             : delivered_messages(other.delivered_messages.load())
             , dropped_messages(other.dropped_messages.load())
-            , total_delay(other.total_delay.load()) {}
+            , blocked_messages(other.blocked_messages.load())
+            , total_delay(other.total_delay.load())
+            , sent_bytes(other.sent_bytes.load())
+            , saved_bytes(other.saved_bytes.load())
+            , allocations(other.allocations.load())
+            , coalesced_messages(other.coalesced_messages.load())
+            , delivery_batches(other.delivery_batches.load())
+            , by_type(other.by_type)
+            , overall(other.overall)
+            , links(other.links) {}
     } stats;
 
-    bool should_drop_message();
-    int calculate_delay();
+    enum class Route {
+        Deliver,
+        Lost,
+        Blocked
+    };
+    // One trip through the link model: partition check, loss draw, then delay plus
+    // bandwidth queueing. Only a capped link takes a lock (pipe_mutex)
+    Route route(NodeId from_id, NodeId to_id, size_t bytes, double now_ms, int& delay_ms);
+    void change_topology(const std::function<void(LinkModel&)>& change);  // Holds topology_mutex
+    void count_sent(size_t bytes, size_t full_state_bytes);
+    void count_drop(NodeId from_id, NodeId to_id, size_t bytes, Route verdict,
+                    std::chrono::system_clock::time_point send_time);
+    // A pooled envelope for one routed message; allocations counts pool and buffer growth
+    Envelope* wrap(NodeId from_id, NodeId to_id, const std::string& content,
+                   std::chrono::system_clock::time_point send_time,
+                   std::chrono::system_clock::time_point delivery_time, uint64_t& allocations);
+    // With a scheduler: one process_messages per delivery tick, however many messages are due then
+    void wake_at(std::chrono::system_clock::time_point delivery_time);
     void update_stats(int delay, bool dropped);
+    void record_link(NodeId from_id, NodeId to_id, size_t bytes, bool dropped);
+    void record_link_delay(NodeId from_id, NodeId to_id, uint64_t delay_us);
+    std::chrono::system_clock::time_point get_current_time() const;
+    static int64_t to_tick(std::chrono::system_clock::time_point time);
+    void enqueue(Envelope* envelope);
+    void enqueue_all(Envelope* const* envelopes, size_t count);
+    void collect_due(std::chrono::system_clock::time_point now, std::vector<Envelope*>& out);
 
 public:
-    Network();
-    ~Network() = default;
+    Network(std::shared_ptr<TaskScheduler> task_scheduler = nullptr,
+            DeliveryQueue queue_kind = DeliveryQueue::Heap);
+    ~Network() override;
 
     void add_node(const std::string& node_id, std::shared_ptr<Node> node);
     void remove_node(const std::string& node_id);
+    // Drops every undelivered message, so a rebuilt cluster reusing the same ids
+    // never receives the previous cluster's gossip
+    void discard_in_flight();
     std::shared_ptr<Node> get_node(const std::string& node_id);
+    std::shared_ptr<Node> get_node(NodeId node_id);
     void send_message(const std::string& from_id, const std::string& to_id, const std::string& content);
+    void send_message(NodeId from_id, NodeId to_id, const std::string& content,
+                      size_t full_state_bytes = 0) override;
+    // Messages to the same destination share one routing decision (one loss draw,
+    // one delay) and one in-flight envelope chain, like a coalesced packet
+    void send_batch(NodeId from_id, const OutgoingMessage* messages, size_t count) override;
     void process_messages();
+    void on_processed(const Envelope& envelope, uint64_t queueing_us, uint64_t processing_us) override;
+    // Switching moves any in-flight messages to the new structure; call it while no sends are running
+    void set_delivery_queue(DeliveryQueue queue_kind);
+    DeliveryQueue get_delivery_queue() const { return delivery_queue; }
+    // Cuts every link between the two sides (nodes in neither reach both) until
+    // heal_network_partition; with a scheduler, duration_ms > 0 heals it by itself
     void simulate_network_partition(const std::vector<std::string>& partition1,
                                   const std::vector<std::string>& partition2,
                                   int duration_ms);
     void heal_network_partition();
+    // Per-group and per-link parameters and group partitions (format in link_model.hpp).
+    // Loading adds to the current model; clear_topology goes back to uniform defaults
+    bool load_topology(const std::string& file_path, std::string& error);
+    bool load_topology(std::istream& in, std::string& error);
+    void clear_topology();
+    void set_default_link(const LinkParams& params);
+    // Group cuts, independent of simulate_network_partition; false for unknown groups
+    bool partition_groups(const std::string& from_group, const std::string& to_group, bool one_way = false);
+    void heal_group_partitions();
     NetworkStats get_stats() const;
     void reset_stats();
+    void set_link_stats(bool enabled) { link_stats_enabled = enabled; }
+    static MessageType classify(const std::string& content);
+    static const char* message_type_name(MessageType type);
+    void set_seed(uint64_t seed);  // Makes loss and delay draws reproducible
+    // Also attached to every node, current and future; pass nullptr to stop recording
+    void set_trace(TraceRecorder* recorder);
 }; 
\ No newline at end of file
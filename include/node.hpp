@@ -6,48 +6,115 @@
 #include <mutex>
 #include <atomic>
 #include <thread>
-#include <queue>
 #include <functional>
+#include <memory>
+#include "task_scheduler.hpp"
+#include "node_registry.hpp"
+#include "mpsc_inbox.hpp"
+#include "envelope_pool.hpp"
+#include "transport.hpp"
+#include "trace_recorder.hpp"
+#include "membership_observer.hpp"
 
-class Node {
+class Node : public std::enable_shared_from_this<Node> {
 protected:
     std::string id;
+    NodeId numeric_id;  // Interned form of id used on every hot path
     std::atomic<bool> is_alive;
     std::atomic<bool> is_running;
     std::mutex state_mutex;
     std::thread node_thread;
+
+    // When set, ticks are scheduler tasks (virtual clock or worker pool) instead of a thread
+    std::shared_ptr<TaskScheduler> scheduler;
+    const int tick_interval_ms = 100;   // Time between message drains / periodic tasks
+
+    // Set by Network::add_node or UdpTransport::add_node; outgoing messages are dropped while detached
+    std::atomic<Transport*> transport;
+
+    // Coalescing: transmit only queues, and each tick hands the transport one
+    // batch, so same-tick messages to one peer can share an envelope
+    bool coalescing = false;
+    std::vector<OutgoingMessage> outbox;  // Buffers kept between ticks; guarded by outbox_mutex
+    size_t outbox_size = 0;
+    std::mutex outbox_mutex;              // Sends may come from any thread, flushes from the tick
+
+    // When set, every flip of this node's view of a member is reported as the detector makes it
+    std::atomic<TraceRecorder*> trace;
+    std::atomic<MembershipObserver*> observer;
     
-    // Message queue for thread-safe communication
-    struct Message {
-        std::string from_id;
-        std::string content;
-        std::chrono::system_clock::time_point timestamp;
-    };
-    std::queue<Message> message_queue;
-    std::mutex queue_mutex;
+    // Message queue for thread-safe communication. Messages are the network's
+    // pooled envelopes, handed over by pointer and returned to the pool once processed.
+    using Message = Envelope;
+    // Senders push without locking; only the draining side takes drain_mutex
+    MpscInbox<Message> inbox;
+    std::mutex drain_mutex;
+
+    // Inbox counters (drain times are wall-clock, even under a virtual clock)
+    std::atomic<size_t> max_queue_depth;
+    std::atomic<uint64_t> drained_messages;
+    std::atomic<uint64_t> drain_batches;
+    std::atomic<uint64_t> total_drain_us;
+    std::atomic<uint64_t> max_drain_us;
 
 public:
-    Node(const std::string& node_id);
+    struct InboxStats {
+        size_t queue_depth;
+        size_t max_queue_depth;
+        uint64_t drained_messages;
+        uint64_t drain_batches;
+        uint64_t total_drain_us;
+        uint64_t max_drain_us;
+    };
+
+    Node(const std::string& node_id, std::shared_ptr<TaskScheduler> task_scheduler = nullptr);
     virtual ~Node();
 
     // Core functionality
-    virtual void start() = 0;
+    virtual void start();
     virtual void stop();
     virtual void send_message(const std::string& to_id, const std::string& content) = 0;
-    virtual void receive_message(const std::string& from_id, const std::string& content);
+    virtual void receive_message(NodeId from_id, const std::string& content);
+    void receive_message(const std::string& from_id, const std::string& content);
+    // Takes ownership of a pooled envelope (the network's zero-copy path)
+    void receive_envelope(Envelope* envelope);
+    // Several envelopes, oldest first, handed over with one inbox push
+    void receive_batch(Envelope* const* envelopes, size_t count);
     
     // State management
     bool is_node_alive() const { return is_alive; }
     void set_alive(bool status) { is_alive = status; }
     std::string get_id() const { return id; }
+    NodeId get_numeric_id() const { return numeric_id; }
+
+    // This node's current view of which members have failed
+    virtual std::vector<NodeId> get_failed_node_ids() const = 0;
+    virtual bool is_node_failed(NodeId node_id) const = 0;
+    void attach_transport(Transport* target) { transport = target; }
+    void attach_trace(TraceRecorder* recorder) { trace = recorder; }
+    void attach_observer(MembershipObserver* target) { observer = target; }
+    // Call before start(); messages sent outside a tick wait for the next one
+    void set_coalescing(bool enabled) { coalescing = enabled; }
+    bool is_coalescing() const { return coalescing; }
 
     // Message processing
     virtual void process_message(const Message& msg) = 0;
     void process_message_queue();
+    // One tick's work (drain, periodic task, flush) without scheduling the next;
+    // lets tests and benchmarks step a node that was never started
+    void run_tick();
+    InboxStats get_inbox_stats() const;
 
 protected:
     // Helper functions
     void run();
+    void tick();
+    void schedule_tick();
+    // Detectors call this from their membership table's flip handler
+    void report_view_change(NodeId subject, bool failed);
     virtual void periodic_task() = 0;
+    void transmit(NodeId to_id, const std::string& content, size_t full_state_bytes = 0);
+    void flush_outbox();  // End of tick: sends what transmit queued while coalescing
     std::chrono::system_clock::time_point get_current_time() const;
+    int64_t get_current_time_ms() const;
 }; 
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Dense integer handle for a node name. Ids are handed out in interning order
+// starting at 0, so they can index plain arrays.
+using NodeId = uint32_t;
+constexpr NodeId invalid_node_id = std::numeric_limits<NodeId>::max();
+
+// Process-wide name <-> NodeId mapping. Names are interned once when a node
+// or peer is registered; everything on the hot path then works on NodeIds.
+class NodeRegistry {
+private:
+    std::unordered_map<std::string, NodeId> ids;
+    std::deque<std::string> names;  // Deque keeps returned references stable
+    mutable std::shared_mutex registry_mutex;
+
+    NodeRegistry() = default;
+
+public:
+    static NodeRegistry& instance();
+
+    NodeRegistry(const NodeRegistry&) = delete;
+    NodeRegistry& operator=(const NodeRegistry&) = delete;
+
+    NodeId intern(const std::string& name);
+    NodeId find(const std::string& name) const;  // invalid_node_id if never interned
+    const std::string& name(NodeId id) const;
+    size_t size() const;
+};
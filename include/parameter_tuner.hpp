@@ -0,0 +1,49 @@
+#pragma once
+
+#include "batch_runner.hpp"
+#include "scenario_script.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Searches a scenario's tune axes for the detector parameters with the lowest
+// detection latency that stay within its budgets. Every point runs the
+// scenario on the same seeds (in parallel, one virtual-time Simulator per
+// run), first over the full grid, then by bisecting towards the grid
+// neighbours of the best feasible point on each axis.
+class ParameterTuner {
+public:
+    struct Point {
+        DetectorParams params;
+        double median_detection_ms;  // Mean over seeds: the objective
+        double last_detection_ms;
+        double bytes_per_node_s;     // Mean over seeds
+        double mistake_rate;
+        int false_negatives;         // Summed over seeds
+        bool feasible;               // Every crash detected and every budget met
+        bool refined;                // Found by bisection rather than the grid
+    };
+
+    struct Report {
+        std::string scenario;
+        std::vector<std::string> axes;
+        std::vector<Point> points;  // In evaluation order
+        bool found = false;
+        Point best;
+    };
+
+private:
+    BatchRunner runner;
+    int refine_rounds;
+
+    std::vector<Point> evaluate(const ScenarioScript& script, const std::vector<DetectorParams>& candidates,
+                                uint64_t base_seed);
+    static bool better(const Point& a, const Point& b);
+
+public:
+    explicit ParameterTuner(size_t threads = std::thread::hardware_concurrency(), int refine_rounds = 3);
+
+    // Seeds base_seed .. base_seed + script.seeds - 1 for every point
+    Report tune(const ScenarioScript& script, uint64_t base_seed = 1);
+    static void print(const Report& report);
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "node_registry.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Gossip peer selection over a cached peer array. Picks are swaps in a
+// Fisher-Yates shuffle that is carried out lazily, fanout steps at a time, so
+// a round costs O(fanout) and membership changes are O(1):
+//   Random      - a fresh partial shuffle every round
+//   RoundRobin  - the shuffle continues across rounds, so each pass is a random
+//                 permutation and every peer is contacted once per
+//                 ceil(peers / fanout) rounds
+//   ZoneAware   - peers in our zone and in other zones are kept in separate
+//                 round-robin pools; one pick per round crosses zones, the
+//                 rest stay local
+class PeerSampler {
+public:
+    enum class Strategy {
+        Random,
+        RoundRobin,
+        ZoneAware
+    };
+
+private:
+    struct Pool {
+        std::vector<NodeId> ids;
+        size_t cursor = 0;  // ids[0, cursor) were already picked in the current pass
+    };
+    struct Slot {
+        uint32_t index;
+        uint8_t pool;
+        bool present;
+    };
+
+    NodeId self;
+    Strategy strategy = Strategy::Random;
+    std::array<Pool, 2> pools;  // [0] our zone (everyone unless zone-aware), [1] other zones
+    std::vector<Slot> slots;    // Indexed by NodeId
+    std::vector<int> zones;     // Indexed by NodeId, 0 until set
+    std::vector<NodeId> selected;
+
+    int zone_of(NodeId id) const { return id < zones.size() ? zones[id] : 0; }
+    size_t pool_for(NodeId id) const;
+    void insert(NodeId id);
+    void erase(NodeId id);
+    void place(Pool& pool, size_t index, NodeId id);
+    void rebuild();
+    // Appends up to count distinct picks from the pool to selected
+    void draw(Pool& pool, size_t count, std::mt19937& rng);
+
+public:
+    explicit PeerSampler(NodeId self);
+
+    void set_strategy(Strategy value);  // Regroups the peers: O(peers)
+    Strategy get_strategy() const { return strategy; }
+    // Zones only matter to ZoneAware; changing our own zone regroups everyone
+    void set_zone(NodeId id, int zone);
+
+    void add(NodeId id);  // Ignores self and known peers
+    void remove(NodeId id);
+    bool contains(NodeId id) const { return id < slots.size() && slots[id].present; }
+    size_t size() const { return pools[0].ids.size() + pools[1].ids.size(); }
+
+    // Up to count distinct peers; the buffer is reused by the next call
+    const std::vector<NodeId>& select(size_t count, std::mt19937& rng);
+};
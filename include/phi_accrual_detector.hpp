@@ -0,0 +1,43 @@
+#pragma once
+
+#include "node_registry.hpp"
+#include <cstdint>
+#include <vector>
+
+// Phi-accrual failure detector (Hayashibara et al.). For every monitored node
+// it keeps a fixed-size ring of heartbeat inter-arrival times with a running
+// sum and sum of squares, so mean and variance update in O(1) per heartbeat.
+// phi() turns the time since the last heartbeat into a continuous suspicion
+// level: phi = -log10(P(next heartbeat arrives later than now)).
+class PhiAccrualDetector {
+private:
+    struct Window {
+        std::vector<int64_t> intervals;  // Ring buffer, window_size slots
+        size_t next = 0;
+        size_t count = 0;
+        double sum = 0.0;
+        double sum_squares = 0.0;
+        int64_t last_arrival_ms = -1;    // -1 until the first heartbeat
+    };
+
+    std::vector<Window> windows;  // Indexed by NodeId
+    size_t window_size;
+    double first_interval_ms;     // Assumed interval until a real sample exists
+    double min_stddev_ms;         // Floor so perfectly regular arrivals do not make phi explode
+    double acceptable_pause_ms;   // Added to the mean so isolated lost heartbeats are absorbed
+
+public:
+    PhiAccrualDetector(size_t window_size = 100, double first_interval_ms = 1000.0,
+                       double min_stddev_ms = 100.0, double acceptable_pause_ms = 0.0);
+
+    void heartbeat(NodeId id, int64_t now_ms);
+    double phi(NodeId id, int64_t now_ms) const;
+    // Last ms at which phi is still at or below threshold; stays valid until the next heartbeat
+    int64_t suspicion_deadline(NodeId id, double threshold) const;
+    void remove(NodeId id);
+
+    // Window statistics (mean falls back to first_interval_ms with no samples)
+    double mean_interval(NodeId id) const;
+    double stddev_interval(NodeId id) const;
+    size_t sample_count(NodeId id) const;
+};
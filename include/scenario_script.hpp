@@ -0,0 +1,74 @@
+#pragma once
+
+#include "simulator.hpp"
+#include "detector_params.hpp"
+#include "link_model.hpp"
+#include <istream>
+#include <string>
+#include <vector>
+
+// A failure scenario read from a file instead of a hand-written run_*_test.
+// Lines are '#'-commented; settings first, then the steps in order:
+//   name NAME                      label for the results
+//   algorithm gossip|heartbeat|swim
+//   nodes N
+//   set PARAM VALUE                detector parameter (see detector_params.hpp)
+//   network [options]              default link, same options as a topology file
+//   topology FILE                  per-group links, relative to the script
+//   warmup MS                      runs before measurement starts (default 5000)
+//   crash N | crash NODE...        N random live nodes (never a heartbeat monitor)
+//   recover all | recover NODE...
+//   partition half | partition NODE... / NODE...
+//   heal
+//   wait MS
+//   wait-detection MS              until every observer suspects every crashed node
+//                                  (or MS), then one suspicion timeout more
+//   wait-convergence MS            until all views agree
+// Tuning lines are only read by ParameterTuner:
+//   tune PARAM VALUE...            grid values for one parameter
+//   budget bytes_per_node_s X      at most X gossip bytes per node per second
+//   budget mistake_rate X          at most X false positives per pair per second
+//   seeds K                        seeds per evaluated point (default 3)
+struct ScenarioScript {
+    enum class Action {
+        Crash,
+        Recover,
+        Partition,
+        Heal,
+        Wait,
+        WaitDetection,
+        WaitConvergence
+    };
+
+    struct Step {
+        Action action;
+        int count;                       // Crash: random picks; wait steps: milliseconds
+        std::vector<std::string> nodes;  // Named targets; Partition: first side
+        std::vector<std::string> other;  // Partition: second side
+        bool all;                        // Recover all / partition half
+    };
+
+    struct TuneAxis {
+        std::string param;
+        std::vector<int> values;
+    };
+
+    std::string name = "Scenario";
+    Simulator::Algorithm algorithm = Simulator::Algorithm::Gossip;
+    int num_nodes = 10;
+    DetectorParams params;
+    bool has_network = false;
+    LinkParams network;
+    std::string topology_path;
+    int warmup_ms = 5000;
+    std::vector<Step> steps;
+
+    std::vector<TuneAxis> tune;
+    double max_bytes_per_node_s = 0;  // 0: no budget
+    double max_mistake_rate = 0;      // 0: no budget
+    int seeds = 3;
+
+    bool load(const std::string& file_path, std::string& error);
+    // base_dir resolves a relative topology path
+    bool parse(std::istream& in, std::string& error, const std::string& base_dir = "");
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Single-producer single-consumer ring of variable-length records, laid out in
+// caller-provided memory so it can sit in a MAP_SHARED mapping and be used by
+// two processes after fork(). Head and tail are lock-free atomics on their own
+// cache lines; each record is a 4-byte length plus its bytes, padded to 8.
+class ShmRing {
+private:
+    struct Control {
+        alignas(64) std::atomic<uint64_t> head;  // Consumer offset
+        alignas(64) std::atomic<uint64_t> tail;  // Producer offset
+    };
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring offsets must be lock-free");
+
+    static constexpr uint32_t wrap_marker = 0xffffffffu;  // Rest of the buffer is padding
+
+    Control* control;
+    char* data;
+    size_t capacity;  // Power of two
+
+    static size_t record_size(size_t length) { return (4 + length + 7) & ~size_t{7}; }
+
+public:
+    // capacity is rounded up to a power of two
+    static size_t bytes_needed(size_t capacity);
+
+    ShmRing() : control(nullptr), data(nullptr), capacity(0) {}
+    // initialize: reset the offsets (exactly one side does this, before sharing)
+    ShmRing(void* memory, size_t capacity, bool initialize);
+
+    // Producer side; the record is header followed by payload. False if it does not fit yet.
+    bool try_push(const void* header, size_t header_length, const void* payload, size_t payload_length);
+
+    // Consumer side; callback(const char* record, size_t length) sees each record
+    // in place and must copy what it keeps. Returns the number of records.
+    template <typename Callback>
+    size_t drain(Callback&& callback) {
+        uint64_t head = control->head.load(std::memory_order_relaxed);
+        uint64_t tail = control->tail.load(std::memory_order_acquire);
+        size_t records = 0;
+        while (head != tail) {
+            size_t position = head & (capacity - 1);
+            uint32_t length;
+            std::memcpy(&length, data + position, sizeof(length));
+            if (length == wrap_marker) {
+                head += capacity - position;
+                continue;
+            }
+            callback(data + position + 4, static_cast<size_t>(length));
+            head += record_size(length);
+            records++;
+        }
+        control->head.store(head, std::memory_order_release);
+        return records;
+    }
+
+    size_t get_capacity() const { return capacity; }
+};
@@ -1,29 +1,75 @@
 #pragma once
 
+#include "event_scheduler.hpp"
+#include "worker_pool.hpp"
 #include "network.hpp"
 #include "gossip_node.hpp"
 #include "heartbeat_node.hpp"
+#include "swim_node.hpp"
+#include "trace_recorder.hpp"
+#include "accuracy_oracle.hpp"
+#include "convergence_tracker.hpp"
+#include "detector_params.hpp"
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <chrono>
 #include <functional>
+#include <random>
+
+struct ScenarioScript;
 
 class Simulator {
 public:
+    // Detection and accuracy figures come from the ground-truth oracle and
+    // cover the scenario itself, not the warm-up before the first injection
     struct TestResult {
         std::string test_name;
-        double detection_time_ms;
-        int false_positives;
-        int false_negatives;
+        double detection_time_ms;         // Crash to the first observer's suspicion (NaN if nobody got there)
+        double median_detection_ms;       // ... to the median observer's
+        double last_detection_ms;         // ... to the last observer's
+        int false_positives;              // Suspicions raised against live nodes
+        int false_negatives;              // Observers that never suspected a crashed node
+        double mistake_rate;              // False positives per observer/subject pair per second
+        double mean_mistake_ms;           // Duration of a false suspicion
+        double mean_recurrence_ms;        // Time between false suspicions on one pair
         int messages_sent;
-        double accuracy;
+        double accuracy;                  // Query accuracy: share of live pair-time not suspected
+        uint64_t bytes_sent;
+        uint64_t bytes_saved;   // Versus full-state gossip, when delta gossip is enabled
+        double allocations_per_message;  // Send-path heap allocations per delivered message
+        double delivery_p99_ms;          // Tail of send-to-inbox delay
+        double delivery_p999_ms;
+        double queueing_p99_ms;          // Tail of inbox wait before processing
+        double measured_ms;              // Length of the measurement window
+    };
+
+    // One point on the heartbeat detector's latency/accuracy curve, as the oracle scores it
+    struct PhiCurvePoint {
+        double phi_threshold;       // 0 for the fixed-timeout baseline
+        double detection_time_ms;   // Crash to the first master's suspicion; the window length if missed
+        int false_positives;        // Suspicions raised against live workers
+        double accuracy;            // Query accuracy over the window (see TestResult)
+    };
+
+    enum class Algorithm {
+        Gossip,     // All-to-all membership gossip
+        Heartbeat,  // Workers report to node0
+        Swim        // Probe-based with piggybacked dissemination
+    };
+
+    enum class ExecutionMode {
+        ThreadPerNode,  // One std::thread per node, wall-clock time
+        SharedPool,     // Nodes multiplexed over a work-stealing WorkerPool, wall-clock time
+        VirtualTime     // Discrete-event EventScheduler, runs as fast as the CPU allows
     };
 
-    Simulator();
-    ~Simulator() = default;
+    explicit Simulator(ExecutionMode execution_mode = ExecutionMode::ThreadPerNode,
+                       size_t pool_threads = std::thread::hardware_concurrency());
+    ~Simulator();
 
     // Test scenarios
-    TestResult run_single_node_failure_test(int num_nodes);
+    TestResult run_single_node_failure_test(int num_nodes, Algorithm algorithm = Algorithm::Gossip);
     TestResult run_multiple_failures_test(int num_nodes, int num_failures);
     TestResult run_network_partition_test(int num_nodes);
     TestResult run_high_load_test(int num_nodes);
@@ -33,21 +79,113 @@ public:
     std::vector<TestResult> compare_algorithms(int num_nodes);
     void run_all_tests(int num_nodes);
 
+    // Single-failure gossip runs under each peer sampling strategy; the last
+    // observer's detection time is when the cluster converged on the crash
+    std::vector<TestResult> compare_peer_sampling(int num_nodes);
+
+    // Heartbeat latency/accuracy trade-off across phi thresholds, plus the fixed-timeout baseline
+    std::vector<PhiCurvePoint> run_phi_threshold_sweep(int num_nodes, const std::vector<double>& thresholds);
+
+    // Scripted scenario (see scenario_script.hpp). Its detector parameters and
+    // network apply to this run only; a script that sets the network leaves
+    // the uniform default links behind
+    TestResult run_scenario(const ScenarioScript& script);
+
+    // Latency for printing: "n/a" instead of NaN when nothing was detected
+    static std::string format_ms(double ms);
+
+    ExecutionMode get_execution_mode() const { return mode; }
+    bool is_virtual_time() const { return mode == ExecutionMode::VirtualTime; }
+    void set_delta_gossip(bool enabled) { delta_gossip = enabled; }
+    void set_anti_entropy(bool enabled) { anti_entropy = enabled; }
+    // Nodes hand their tick's messages to the network as one batch; messages to the same peer share an envelope
+    void set_coalescing(bool enabled) { coalescing = enabled; }
+    void set_peer_sampling(PeerSampler::Strategy strategy) { peer_sampling = strategy; }
+    // Gossip and heartbeat timing for every network set up from now on; SWIM keeps its own
+    void set_detector_params(const DetectorParams& params) { detector_params = params; }
+    const DetectorParams& get_detector_params() const { return detector_params; }
+    // Gossip nodes are dealt round-robin into this many zones (racks) for ZoneAware sampling
+    void set_zones(int count) { zones = std::max(1, count); }
+    void set_delivery_queue(Network::DeliveryQueue queue_kind) { network.set_delivery_queue(queue_kind); }
+    // Heartbeat networks shard workers over the first monitors nodes with a consistent-hash ring
+    void set_heartbeat_monitors(int monitors, int replicas = 1);
+    // Every random stream (failure picks, link loss and delay, node peer
+    // selection) derives from this one seed; by default it is drawn at startup
+    void set_seed(uint64_t seed);
+    uint64_t get_seed() const { return run_seed; }
+
+    // Records sends, drops, deliveries, suspicion changes and failure
+    // injections to a binary trace (see trace_replay.hpp) until stop_trace
+    bool start_trace(const std::string& path);
+    void stop_trace();
+
+    // Per-group and per-link loss, delay, bandwidth and partitions (see link_model.hpp);
+    // node ids in the file are the scenario ids, node0 .. nodeN-1
+    bool load_topology(const std::string& file_path, std::string& error) {
+        return network.load_topology(file_path, error);
+    }
+
+    // Per-link counters and delay histograms (off by default; they grow with the links in use)
+    void set_link_stats(bool enabled) { network.set_link_stats(enabled); }
+    // Delay percentiles per message type and the slowest links since the last stats reset
+    void print_latency_report(size_t worst_links = 5) const;
+
 private:
+    ExecutionMode mode;
+    std::shared_ptr<EventScheduler> virtual_clock;  // VirtualTime mode only
+    std::shared_ptr<WorkerPool> worker_pool;        // SharedPool mode only
+    std::shared_ptr<TaskScheduler> scheduler;       // Drives nodes and deliveries; null for ThreadPerNode
     Network network;
+    std::vector<std::string> active_node_ids;
+    std::vector<NodeId> active_numeric_ids;  // Interned once per setup, reused by every poll
+    bool delta_gossip = false;
+    bool anti_entropy = false;
+    bool coalescing = false;
+    PeerSampler::Strategy peer_sampling = PeerSampler::Strategy::Random;
+    int zones = 1;
+    int heartbeat_monitors = 1;
+    int heartbeat_replicas = 1;
+    DetectorParams detector_params;
+    int64_t measurement_start_ms = 0;
+    uint64_t run_seed;
+    std::mt19937 rng;  // Picks failed nodes; seeded by set_seed for reproducible runs
+    std::unique_ptr<TraceRecorder> trace;
+    AccuracyOracle oracle;  // Ground truth for the current network, reset by every setup
+    ConvergenceTracker convergence;
+    MembershipFanout view_observers;  // Every node reports its view flips here: oracle and tracker
     
     // Helper functions
     void setup_gossip_network(int num_nodes);
-    void setup_heartbeat_network(int num_nodes);
+    void setup_heartbeat_network(int num_nodes, double phi_threshold = 0.0);  // <= 0: fixed timeout
+    void setup_swim_network(int num_nodes);
+    void setup_network(Algorithm algorithm, int num_nodes);
+    // Interns the ids and registers them with the oracle and the convergence tracker;
+    // the first observers nodes' views count
+    void register_members(const std::vector<std::string>& node_ids, int observers);
+    PhiCurvePoint measure_heartbeat_detection(int num_nodes, double phi_threshold);
+    int monitor_count(int num_nodes) const;
+    int random_index(int low, int high);  // Uniform in [low, high]
+    uint64_t node_seed(size_t index) const;  // Independent stream per node
+    void record_injection(TraceEvent type, const std::string& node_id);
     void cleanup_network();
     
     // Metrics collection
     TestResult collect_metrics(const std::string& test_name);
-    double calculate_accuracy(int true_positives, int false_positives, int false_negatives);
+    void begin_measurement();  // Scenario metrics start here
     
+    // Time control
+    void advance_time(int duration_ms);
+    std::chrono::system_clock::time_point current_time() const;
+    int64_t current_time_ms() const;
+    long long elapsed_ms(std::chrono::system_clock::time_point since) const;
+
     // Test utilities
     void wait_for_convergence(int timeout_ms);
-    bool check_convergence();
+    // Until every live observer suspects every crashed node, then one suspicion timeout
+    // more so false suspicions raised alongside the last detection are scored too
+    void wait_for_detection(int timeout_ms);
+    int suspicion_timeout_ms() const;
+    bool check_convergence();  // O(1): answered by the convergence tracker
     void simulate_failures(const std::vector<std::string>& node_ids);
     void simulate_recoveries(const std::vector<std::string>& node_ids);
 }; 
\ No newline at end of file
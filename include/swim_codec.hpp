@@ -0,0 +1,72 @@
+#pragma once
+
+#include "node_registry.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// SWIM probe wire format (version 1):
+//   header: magic 'S', format version byte, message type byte,
+//           varint probe sequence number, subject NodeId (4 little-endian bytes)
+//   update: NodeId (4 little-endian bytes), member state byte, varint incarnation
+// The subject is the node to probe for a PingReq and the original requester
+// (or invalid_node_id) for a Ping/Ack. Membership updates piggyback on every
+// message and repeat until the end of the buffer.
+enum class SwimMessageType : uint8_t {
+    Ping = 1,
+    Ack = 2,
+    PingReq = 3
+};
+
+enum class SwimMemberState : uint8_t {
+    Alive = 0,
+    Suspect = 1,
+    Dead = 2
+};
+
+struct SwimHeader {
+    SwimMessageType type;
+    uint64_t seq;
+    NodeId subject;
+};
+
+struct SwimUpdate {
+    NodeId id;
+    SwimMemberState state;
+    uint64_t incarnation;
+};
+
+class SwimEncoder {
+private:
+    std::string& out;
+
+public:
+    static constexpr uint8_t magic = 'S';
+    static constexpr uint8_t format_version = 1;
+    static constexpr size_t id_size = 4;
+
+    // Clears (but keeps the capacity of) the buffer and writes the header
+    SwimEncoder(std::string& buffer, const SwimHeader& header);
+
+    void add(const SwimUpdate& update);
+};
+
+class SwimDecoder {
+private:
+    std::string_view data;
+    size_t pos;
+    bool error;
+    SwimHeader header;
+
+public:
+    explicit SwimDecoder(std::string_view buffer);
+
+    const SwimHeader& get_header() const { return header; }
+
+    // Returns false at the end of the buffer or on malformed input
+    bool next(SwimUpdate& update);
+    bool has_error() const { return error; }
+
+private:
+    bool read_id(NodeId& id);
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "node.hpp"
+#include "membership_table.hpp"
+#include "swim_codec.hpp"
+#include <random>
+
+// SWIM-style detector (Das, Gupta, Motivala). Each protocol period a node
+// pings one member chosen by randomized round-robin; if no ack arrives within
+// ping_timeout_ms it asks indirect_probes other members to ping-req the target.
+// A target silent for the whole period becomes Suspect, and Dead once
+// suspicion_timeout_ms passes without a refutation. Members refute suspicion
+// of themselves by bumping their incarnation number. State changes travel
+// piggybacked on probe traffic, so per-node load stays constant as N grows.
+class SwimNode : public Node {
+private:
+    // Liveness lives in the table (alive until confirmed Dead); SWIM columns
+    // below are parallel arrays indexed by the same NodeId
+    MembershipTable members;
+    std::vector<SwimMemberState> states;
+    std::vector<uint64_t> incarnations;   // incarnations[numeric_id] is our own
+    std::vector<int64_t> suspect_since_ms;
+    std::vector<NodeId> suspects;         // Members currently Suspect, so expiry never scans N
+    mutable std::mutex states_mutex;
+
+    // Updates waiting to be piggybacked, each carried a bounded number of times
+    struct PendingUpdate {
+        SwimUpdate update;
+        int transmissions;
+    };
+    std::vector<PendingUpdate> pending_updates;
+
+    // Current protocol period, guarded by states_mutex
+    std::vector<NodeId> probe_order;      // Shuffled round-robin over live members
+    size_t probe_index = 0;
+    NodeId probe_target = invalid_node_id;
+    uint64_t probe_seq = 0;
+    bool probe_acked = true;
+    bool indirect_sent = false;
+    std::chrono::system_clock::time_point probe_started;
+
+    // SWIM parameters
+    const int probe_interval_ms = 1000;   // Protocol period
+    const int ping_timeout_ms = 300;      // Wait for a direct ack before asking others
+    const int indirect_probes = 3;        // Members asked to ping a silent target (k)
+    const int max_piggyback = 6;          // Updates carried per message
+    const int retransmit_mult = 3;        // Updates are carried retransmit_mult * log2(N + 1) times
+    int suspicion_timeout_ms = 2000;      // Suspect -> Dead unless refuted
+
+    std::mt19937 rng;
+
+    // Messages built under states_mutex and transmitted after it is released
+    struct Outgoing {
+        NodeId to_id;
+        std::string content;
+    };
+
+    // Metrics
+    struct Metrics {
+        int messages_sent;
+        int messages_received;
+        int probes_sent;
+        int indirect_probes_sent;
+        std::chrono::system_clock::time_point last_metrics_reset;
+    } metrics;
+
+public:
+    SwimNode(const std::string& node_id, const std::vector<std::string>& peer_ids,
+             std::shared_ptr<TaskScheduler> task_scheduler = nullptr);
+    ~SwimNode() override = default;
+
+    // Core functionality
+    void send_message(const std::string& to_id, const std::string& content) override;
+    void process_message(const Message& msg) override;
+
+    // State management
+    std::vector<std::string> get_failed_nodes() const;
+    std::vector<NodeId> get_failed_node_ids() const override;
+    bool is_node_failed(NodeId node_id) const override;
+    SwimMemberState get_member_state(NodeId node_id) const;
+    uint64_t get_incarnation() const;
+    void add_peer(const std::string& peer_id);
+    void remove_peer(const std::string& peer_id);
+    void set_suspicion_timeout(int timeout_ms) { suspicion_timeout_ms = timeout_ms; }
+    // Makes probe order and indirect-probe picks reproducible
+    void set_seed(uint64_t seed) { rng.seed(static_cast<std::mt19937::result_type>(seed)); }
+
+    // Metrics
+    Metrics get_metrics() const;
+    void reset_metrics();
+
+protected:
+    void periodic_task() override;
+
+private:
+    // Helper functions (all expect states_mutex to be held)
+    void add_member(NodeId member_id);
+    void start_probe(std::vector<Outgoing>& outbox);
+    NodeId next_probe_target();
+    std::vector<NodeId> select_random_members(size_t count, NodeId exclude);
+    void apply_update(const SwimUpdate& update, int64_t now_ms);
+    void set_member_state(NodeId member_id, SwimMemberState state, uint64_t incarnation, int64_t now_ms);
+    void expire_suspicions(int64_t now_ms);
+    void enqueue_update(const SwimUpdate& update);
+    void queue_message(std::vector<Outgoing>& outbox, NodeId to_id, SwimMessageType type,
+                       uint64_t seq, NodeId subject);
+    int retransmit_limit() const;
+
+    void flush(std::vector<Outgoing>& outbox);
+};
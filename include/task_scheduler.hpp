@@ -0,0 +1,22 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+
+// Something that can run callbacks at a point in time. Nodes and the Network
+// use this to run their ticks and deliveries without owning a thread: the
+// EventScheduler runs them on a virtual clock, the WorkerPool on real threads.
+class TaskScheduler {
+public:
+    using TimePoint = std::chrono::system_clock::time_point;
+    using Callback = std::function<void()>;
+
+    virtual ~TaskScheduler() = default;
+
+    virtual TimePoint now() const = 0;
+    virtual void schedule_at(TimePoint when, Callback callback) = 0;
+
+    void schedule_after(int delay_ms, Callback callback) {
+        schedule_at(now() + std::chrono::milliseconds(delay_ms > 0 ? delay_ms : 0), std::move(callback));
+    }
+};
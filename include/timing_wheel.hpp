@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Hierarchical timing wheel keyed by integer ticks (the Network uses ms).
+// Four levels of 256 slots cover 2^32 ticks; an item is filed in the lowest
+// level whose block still contains the current tick and is cascaded down as
+// time reaches its block, so insert and expiry are O(1) amortized. Items due
+// beyond the top level wait in an overflow list.
+template <typename T>
+class TimingWheel {
+public:
+    static constexpr int slot_bits = 8;
+    static constexpr int64_t slots_per_level = int64_t{1} << slot_bits;
+    static constexpr int levels = 4;
+
+private:
+    struct Entry {
+        int64_t due_tick;
+        T item;
+    };
+
+    std::vector<std::vector<Entry>> slots;  // levels * slots_per_level buckets
+    std::vector<Entry> overdue;             // Inserted at or before the current tick
+    std::vector<Entry> overflow;            // Beyond the top level
+    std::vector<Entry> cascade_buffer;
+    int64_t current_tick;
+    size_t count;
+
+    std::vector<Entry>& bucket(int level, int64_t tick) {
+        int64_t slot = (tick >> (slot_bits * level)) & (slots_per_level - 1);
+        return slots[static_cast<size_t>(level * slots_per_level + slot)];
+    }
+
+    void place(Entry&& entry) {
+        if (entry.due_tick <= current_tick) {
+            overdue.push_back(std::move(entry));
+            return;
+        }
+        for (int level = 0; level < levels; ++level) {
+            int shift = slot_bits * (level + 1);
+            if ((entry.due_tick >> shift) == (current_tick >> shift)) {
+                bucket(level, entry.due_tick).push_back(std::move(entry));
+                return;
+            }
+        }
+        overflow.push_back(std::move(entry));
+    }
+
+    void cascade(std::vector<Entry>& source) {
+        cascade_buffer.swap(source);
+        for (auto& entry : cascade_buffer) {
+            place(std::move(entry));
+        }
+        cascade_buffer.clear();
+    }
+
+    template <typename Callback>
+    void expire(std::vector<Entry>& source, Callback& on_expire) {
+        count -= source.size();
+        for (auto& entry : source) {
+            on_expire(std::move(entry.item));
+        }
+        source.clear();  // Keeps capacity for the next lap
+    }
+
+public:
+    explicit TimingWheel(int64_t start_tick = 0)
+        : slots(static_cast<size_t>(levels * slots_per_level)), current_tick(start_tick), count(0) {}
+
+    void insert(int64_t due_tick, T item) {
+        place({due_tick, std::move(item)});
+        count++;
+    }
+
+    // Hands every item due at or before now_tick to on_expire, in tick order
+    template <typename Callback>
+    void advance(int64_t now_tick, Callback&& on_expire) {
+        expire(overdue, on_expire);
+
+        while (current_tick < now_tick) {
+            if (count == 0) {
+                current_tick = now_tick;  // Nothing pending: jump straight there
+                break;
+            }
+
+            current_tick++;
+            // Entering a new block at level N pulls that block's bucket down a level.
+            // Cascade from the highest boundary crossed so refiled items land in
+            // lower buckets that have not been emptied yet this tick.
+            int top = 0;
+            while (top + 1 < levels &&
+                   (current_tick & ((int64_t{1} << (slot_bits * (top + 1))) - 1)) == 0) {
+                top++;
+            }
+            if (top == levels - 1) {
+                cascade(overflow);
+            }
+            for (int level = top; level >= 1; --level) {
+                cascade(bucket(level, current_tick));
+            }
+            expire(bucket(0, current_tick), on_expire);
+            expire(overdue, on_expire);
+        }
+    }
+
+    // Removes every pending item regardless of due time
+    template <typename Callback>
+    void drain(Callback&& on_item) {
+        expire(overdue, on_item);
+        expire(overflow, on_item);
+        for (auto& slot : slots) {
+            expire(slot, on_item);
+        }
+    }
+
+    size_t size() const { return count; }
+    int64_t get_current_tick() const { return current_tick; }
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "node_registry.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+enum class TraceEvent : uint8_t {
+    Send = 1,      // subject = sender, peer = receiver, size = payload bytes
+    Drop = 2,      // Lost on the link; same fields as Send
+    Deliver = 3,   // Handed to the receiver's inbox
+    Suspect = 4,   // subject = observer, peer = node it now considers failed
+    Clear = 5,     // subject = observer, peer = node it no longer considers failed
+    Crash = 6,     // Failure injection: subject stops
+    Recover = 7,   // Failure injection: subject restarts
+    Leave = 8      // subject was removed from the network; its views and liveness reset
+};
+
+// Fixed-size on-disk record
+struct TraceRecord {
+    int64_t time_ms;
+    NodeId subject;
+    NodeId peer;
+    uint32_t size;
+    uint8_t type;
+    uint8_t reserved[3];
+};
+static_assert(sizeof(TraceRecord) == 24, "trace records are 24 bytes on disk");
+
+// File header: magic, version, run seed, record count
+struct TraceHeader {
+    char magic[4];  // "FDTR"
+    uint32_t version;
+    uint64_t seed;
+    uint64_t records;
+    uint64_t reserved;
+};
+static_assert(sizeof(TraceHeader) == 32, "trace header is 32 bytes on disk");
+
+// Appends trace records to a memory-mapped file, doubling the mapping as it
+// fills. Appends take one short lock (a memcpy); the file is trimmed to the
+// records written when the recorder is closed.
+class TraceRecorder {
+private:
+    static constexpr size_t initial_bytes = size_t{1} << 20;
+
+    int fd;
+    char* mapping;
+    size_t mapped_bytes;
+    uint64_t records;
+    std::string path;
+    mutable std::mutex mutex;
+
+    bool remap(size_t bytes);  // Callers hold mutex
+
+public:
+    TraceRecorder();
+    ~TraceRecorder();
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    // Truncates any existing file
+    bool open(const std::string& file_path, uint64_t seed);
+    void close();
+    bool is_open() const;
+
+    void record(TraceEvent type, int64_t time_ms, NodeId subject, NodeId peer = invalid_node_id,
+                uint32_t size = 0);
+    uint64_t get_record_count() const;
+};
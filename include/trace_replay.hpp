@@ -0,0 +1,79 @@
+#pragma once
+
+#include "trace_recorder.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Read-only view of a trace written by TraceRecorder. Replay walks the mapped
+// records in order and rebuilds every observer's suspicion set alongside the
+// injected ground truth, so a false-positive storm can be located (and
+// bisected by time) without rerunning the scenario.
+class TraceReplay {
+private:
+    int fd;
+    const char* mapping;
+    size_t mapped_bytes;
+    TraceHeader header;
+    const TraceRecord* records;
+    size_t count;
+
+public:
+    struct Summary {
+        uint64_t sends;
+        uint64_t drops;
+        uint64_t deliveries;
+        uint64_t suspicions;
+        uint64_t clears;
+        uint64_t crashes;
+        uint64_t recoveries;
+        uint64_t false_suspicions;      // Suspect records whose target was up at the time
+        size_t peak_false_positives;    // Most (observer, live node) pairs suspected at once
+        int64_t peak_time_ms;           // When that peak was first reached
+        int64_t end_time_ms;
+    };
+
+    // Activity in one slice of the run
+    struct Bucket {
+        int64_t start_ms;
+        uint64_t messages;              // Sends in this slice
+        uint64_t false_suspicions;      // New false suspicions in this slice
+        size_t false_positives;         // Pairs suspected wrongly at the end of the slice
+    };
+
+    TraceReplay();
+    ~TraceReplay();
+    TraceReplay(const TraceReplay&) = delete;
+    TraceReplay& operator=(const TraceReplay&) = delete;
+
+    bool open(const std::string& file_path);
+    void close();
+
+    uint64_t get_seed() const { return header.seed; }
+    size_t size() const { return count; }
+    const TraceRecord& at(size_t index) const { return records[index]; }
+
+    // Calls visitor(const TraceRecord&) in append order for every record with
+    // time_ms <= until_ms (threads can append slightly out of time order)
+    template <typename Visitor>
+    size_t replay(int64_t until_ms, Visitor&& visitor) const {
+        size_t visited = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (records[i].time_ms > until_ms) {
+                continue;
+            }
+            visitor(records[i]);
+            visited++;
+        }
+        return visited;
+    }
+
+    Summary summarize() const;
+    std::vector<Bucket> timeline(int64_t bucket_ms) const;
+    // Wrongly suspected pairs once every record up to time_ms has applied
+    size_t false_positives_at(int64_t time_ms) const;
+    // Earliest time at least threshold pairs are wrongly suspected, found by
+    // bisecting over time; -1 if it never happens
+    int64_t find_false_positive_onset(size_t threshold) const;
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "node_registry.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// Where a node's outgoing messages go. The simulated Network and the real UDP
+// backend both implement it, so detector code is identical in simulation and
+// on real sockets.
+struct Envelope;
+
+// One message of a coalesced send (see Node::set_coalescing). The sender owns
+// the buffers and reuses them from one flush to the next.
+struct OutgoingMessage {
+    NodeId to_id;
+    std::string content;
+    size_t full_state_bytes;
+};
+
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    // full_state_bytes: size the payload would have had as a full-state message (0 if it is one)
+    virtual void send_message(NodeId from_id, NodeId to_id, const std::string& content,
+                              size_t full_state_bytes = 0) = 0;
+
+    // Everything one sender produced in a tick. Transports that can share work
+    // between messages to the same peer override this; the default sends each alone.
+    virtual void send_batch(NodeId from_id, const OutgoingMessage* messages, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            send_message(from_id, messages[i].to_id, messages[i].content, messages[i].full_state_bytes);
+        }
+    }
+
+    // Called by the receiving node after process_message: how long the message
+    // sat in its inbox (node clock) and how long processing took (wall clock)
+    virtual void on_processed(const Envelope& /*envelope*/, uint64_t /*queueing_us*/,
+                              uint64_t /*processing_us*/) {}
+};
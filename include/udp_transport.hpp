@@ -0,0 +1,102 @@
+#pragma once
+
+#include "transport.hpp"
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Node;  // Forward declaration
+
+// Real datagrams over 127.0.0.1 (Linux only). Every node owns a UDP socket
+// bound to an ephemeral loopback port. Sends are queued and flushed with
+// sendmmsg from one shared socket, either when a batch fills or on the event
+// loop's next pass; one epoll loop drains readable sockets with recvmmsg
+// straight into pooled envelopes.
+class UdpTransport : public Transport {
+private:
+    struct Endpoint {
+        int fd = -1;
+        sockaddr_in address{};
+        std::shared_ptr<Node> node;
+    };
+
+    struct Outgoing {
+        sockaddr_in address;
+        std::string datagram;  // 4-byte sender id followed by the payload
+    };
+
+    static constexpr size_t max_batch = 64;         // Datagrams per sendmmsg / recvmmsg
+    static constexpr size_t max_datagram = 65507;   // Largest UDP payload over IPv4
+    static constexpr int flush_interval_ms = 1;     // Longest a queued datagram waits
+    static constexpr int receive_buffer_bytes = 1 << 20;
+
+    std::vector<Endpoint> endpoints;  // Indexed by NodeId
+    std::mutex endpoints_mutex;
+
+    int send_fd;
+    int epoll_fd;
+    int wake_fd;  // eventfd that interrupts epoll_wait on stop
+
+    // Outbox slots are reused so queued datagrams keep their buffers
+    std::vector<Outgoing> outbox;
+    size_t outbox_size = 0;
+    std::vector<mmsghdr> send_headers;
+    std::vector<iovec> send_iovecs;
+    std::mutex outbox_mutex;
+
+    // Only the event loop receives, so these need no lock
+    std::vector<char> receive_buffer;
+    std::vector<mmsghdr> receive_headers;
+    std::vector<iovec> receive_iovecs;
+
+    std::atomic<bool> running;
+    std::thread loop_thread;
+
+    std::atomic<uint64_t> datagrams_sent;
+    std::atomic<uint64_t> datagrams_received;
+    std::atomic<uint64_t> send_calls;
+    std::atomic<uint64_t> receive_calls;
+    std::atomic<uint64_t> bytes_sent;
+    std::atomic<uint64_t> dropped;  // Unroutable, oversized or refused by the kernel
+
+    void event_loop();
+    void flush_locked();  // Callers hold outbox_mutex
+    void receive_batch(NodeId node_id, int fd);
+
+public:
+    struct Stats {
+        uint64_t datagrams_sent;
+        uint64_t datagrams_received;
+        uint64_t send_calls;       // sendmmsg syscalls
+        uint64_t receive_calls;    // recvmmsg syscalls that returned data
+        uint64_t bytes_sent;
+        uint64_t dropped;
+    };
+
+    UdpTransport();
+    ~UdpTransport() override;
+    UdpTransport(const UdpTransport&) = delete;
+    UdpTransport& operator=(const UdpTransport&) = delete;
+
+    bool is_open() const { return send_fd >= 0 && epoll_fd >= 0 && wake_fd >= 0; }
+
+    // Binds a socket for the node and attaches it; false if the socket could not be set up
+    bool add_node(std::shared_ptr<Node> node);
+    void remove_node(NodeId node_id);
+
+    // The event loop runs on its own thread between start and stop
+    void start();
+    void stop();
+
+    void send_message(NodeId from_id, NodeId to_id, const std::string& content,
+                      size_t full_state_bytes = 0) override;
+    void flush();
+
+    Stats get_stats() const;
+};
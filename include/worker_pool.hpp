@@ -0,0 +1,75 @@
+#pragma once
+
+#include "task_scheduler.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed pool of work-stealing worker threads. Each node's ticks and each
+// network delivery run as a short task, so thousands of nodes share a handful
+// of threads and idle nodes cost nothing. Delayed tasks wait on a timer heap
+// and are handed to the workers when they fall due.
+class WorkerPool : public TaskScheduler {
+private:
+    struct Worker {
+        std::deque<Callback> tasks;
+        std::mutex mutex;
+    };
+
+    struct Timer {
+        TimePoint time;
+        uint64_t seq;
+        Callback callback;
+
+        bool operator<(const Timer& other) const {
+            if (time != other.time) {
+                return time > other.time;  // For min-heap priority queue
+            }
+            return seq > other.seq;
+        }
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> worker_threads;
+    std::mutex idle_mutex;
+    std::condition_variable idle_cv;
+    std::atomic<int64_t> queued_tasks;
+
+    std::priority_queue<Timer> timers;
+    std::mutex timers_mutex;
+    std::condition_variable timers_cv;
+    std::thread timer_thread;
+    uint64_t next_seq;
+
+    std::atomic<bool> running;
+    std::atomic<size_t> next_worker;
+    std::atomic<uint64_t> executed_tasks;
+    std::atomic<uint64_t> stolen_tasks;
+
+    void worker_loop(size_t index);
+    void timer_loop();
+    bool pop_task(size_t index, Callback& out);
+
+public:
+    explicit WorkerPool(size_t num_threads = std::thread::hardware_concurrency());
+    ~WorkerPool() override;
+
+    // TaskScheduler interface (wall-clock time)
+    TimePoint now() const override;
+    void schedule_at(TimePoint when, Callback callback) override;
+
+    // Run a task as soon as a worker is free
+    void submit(Callback callback);
+    void shutdown();
+
+    // Introspection
+    size_t get_thread_count() const { return workers.size(); }
+    uint64_t get_executed_tasks() const { return executed_tasks.load(std::memory_order_relaxed); }
+    uint64_t get_stolen_tasks() const { return stolen_tasks.load(std::memory_order_relaxed); }
+};
@@ -0,0 +1,274 @@
+#include "accuracy_oracle.hpp"
+#include <limits>
+
+size_t AccuracyOracle::observers_of(NodeId subject) const {
+    auto it = members.find(subject);
+    bool self = it != members.end() && it->second.observer;
+    return observer_count - (self ? 1 : 0);
+}
+
+void AccuracyOracle::close_wrong(Pair& pair, int64_t now_ms) {
+    if (pair.wrong_since < 0) {
+        return;
+    }
+    int64_t duration = now_ms - pair.wrong_since;
+    wrong_ms += duration;
+    if (pair.false_positive) {
+        closed_mistakes++;
+        closed_mistake_ms += duration;
+    }
+    pair.wrong_since = -1;
+    pair.false_positive = false;
+}
+
+void AccuracyOracle::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    members.clear();
+    pairs.clear();
+    detections.clear();
+    observer_count = 0;
+    closed_uptime_ms = 0;
+    false_positives = 0;
+    closed_mistakes = 0;
+    closed_mistake_ms = 0;
+    wrong_ms = 0;
+    recurrences = 0;
+    recurrence_ms = 0;
+    recovery_clears = 0;
+    recovery_ms = 0;
+    missed = 0;
+    pending = 0;
+}
+
+void AccuracyOracle::begin_window(int64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // Crashes still in progress carry over, renumbered
+    std::vector<Detection> open;
+    std::unordered_map<size_t, size_t> renumbered;
+    for (auto& [id, member] : members) {
+        if (member.up) {
+            member.up_since = now_ms;
+        } else if (member.open_episode != no_episode) {
+            renumbered[member.open_episode] = open.size();
+            open.push_back(std::move(detections[member.open_episode]));
+            member.open_episode = open.size() - 1;
+        }
+    }
+    detections = std::move(open);
+    for (auto& [k, pair] : pairs) {
+        if (pair.wrong_since >= 0) {
+            pair.wrong_since = now_ms;
+        }
+        pair.last_false_positive = -1;
+        auto it = renumbered.find(pair.detected_episode);
+        pair.detected_episode = it != renumbered.end() ? it->second : no_episode;
+    }
+    closed_uptime_ms = 0;
+    false_positives = 0;
+    closed_mistakes = 0;
+    closed_mistake_ms = 0;
+    wrong_ms = 0;
+    recurrences = 0;
+    recurrence_ms = 0;
+    recovery_clears = 0;
+    recovery_ms = 0;
+    missed = 0;
+}
+
+void AccuracyOracle::add_member(NodeId id, bool observer, int64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = members.find(id);
+    if (it != members.end()) {
+        observer_count -= it->second.observer ? 1 : 0;
+    }
+    members[id] = Member{observer, true, now_ms, no_episode};
+    observer_count += observer ? 1 : 0;
+}
+
+void AccuracyOracle::record_crash(NodeId id, int64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = members.find(id);
+    if (it == members.end() || !it->second.up) {
+        return;
+    }
+    Member& crashed = it->second;
+    crashed.up = false;
+    closed_uptime_ms += (now_ms - crashed.up_since) * static_cast<int64_t>(observers_of(id));
+    
+    // Observers already suspecting it were right all along: their mistake ends and they detect at once
+    size_t episode = detections.size();
+    Detection detection{id, now_ms, -1, 0, {}};
+    for (const auto& [observer, member] : members) {
+        if (!member.observer || !member.up || observer == id) {
+            continue;
+        }
+        detection.observers++;
+        auto pair = pairs.find(key(observer, id));
+        if (pair != pairs.end() && pair->second.suspected) {
+            close_wrong(pair->second, now_ms);
+            detection.latencies_ms.push_back(0);
+            pair->second.detected_episode = episode;
+        }
+    }
+    
+    // A crashed observer's view is frozen, so it no longer counts for or against anyone
+    if (crashed.observer) {
+        for (const auto& [subject, member] : members) {
+            auto pair = pairs.find(key(id, subject));
+            if (member.open_episode != no_episode &&
+                (pair == pairs.end() || pair->second.detected_episode != member.open_episode)) {
+                detections[member.open_episode].observers--;
+                pending--;
+            }
+            if (pair != pairs.end()) {
+                close_wrong(pair->second, now_ms);
+            }
+        }
+    }
+    pending += detection.observers - detection.latencies_ms.size();
+    detections.push_back(std::move(detection));
+    crashed.open_episode = episode;
+}
+
+void AccuracyOracle::record_recovery(NodeId id, int64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = members.find(id);
+    if (it == members.end() || it->second.up) {
+        return;
+    }
+    Member& recovered = it->second;
+    recovered.up = true;
+    recovered.up_since = now_ms;
+    if (recovered.open_episode != no_episode) {
+        Detection& detection = detections[recovered.open_episode];
+        detection.recover_ms = now_ms;
+        missed += detection.observers - detection.latencies_ms.size();
+        pending -= detection.observers - detection.latencies_ms.size();
+        recovered.open_episode = no_episode;
+    }
+    
+    // Suspicions that outlive the recovery are wrong from now on, but they are stale, not new mistakes
+    for (const auto& [observer, member] : members) {
+        if (!member.observer || !member.up || observer == id) {
+            continue;
+        }
+        auto pair = pairs.find(key(observer, id));
+        if (pair != pairs.end() && pair->second.suspected) {
+            pair->second.wrong_since = now_ms;
+            pair->second.false_positive = false;
+        }
+    }
+}
+
+void AccuracyOracle::on_view_change(NodeId observer, NodeId subject, bool suspected, int64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto watcher = members.find(observer);
+    auto target = members.find(subject);
+    if (watcher == members.end() || target == members.end() ||
+        !watcher->second.observer || !watcher->second.up) {
+        return;
+    }
+    Pair& pair = pairs[key(observer, subject)];
+    if (pair.suspected == suspected) {
+        return;
+    }
+    pair.suspected = suspected;
+    
+    const Member& member = target->second;
+    if (suspected && member.up) {
+        false_positives++;
+        if (pair.last_false_positive >= 0) {
+            recurrences++;
+            recurrence_ms += now_ms - pair.last_false_positive;
+        }
+        pair.last_false_positive = now_ms;
+        pair.wrong_since = now_ms;
+        pair.false_positive = true;
+    } else if (suspected) {
+        size_t episode = member.open_episode;
+        if (episode != no_episode && pair.detected_episode != episode) {
+            detections[episode].latencies_ms.push_back(now_ms - detections[episode].crash_ms);
+            pair.detected_episode = episode;
+            pending--;
+        }
+    } else if (pair.wrong_since >= 0) {
+        if (!pair.false_positive) {
+            recovery_clears++;
+            recovery_ms += now_ms - pair.wrong_since;
+        }
+        close_wrong(pair, now_ms);
+    }
+}
+
+size_t AccuracyOracle::pending_detections() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending;
+}
+
+AccuracyOracle::Report AccuracyOracle::report(int64_t now_ms) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Report result{};
+    result.crashes = detections.size();
+    result.missed = missed;
+    result.false_positives = false_positives;
+    
+    double first_sum = 0, median_sum = 0, last_sum = 0;
+    size_t firsts = 0, medians = 0, lasts = 0;
+    for (const auto& detection : detections) {
+        const auto& latencies = detection.latencies_ms;
+        result.detections += latencies.size();
+        if (detection.recover_ms < 0) {
+            result.missed += detection.observers - latencies.size();
+        }
+        if (!latencies.empty()) {
+            first_sum += latencies.front();
+            firsts++;
+        }
+        // The median observer is the ceil(n/2)-th one to notice
+        size_t median_rank = detection.observers > 0 ? (detection.observers - 1) / 2 : 0;
+        if (latencies.size() > median_rank) {
+            median_sum += latencies[median_rank];
+            medians++;
+        }
+        if (detection.observers > 0 && latencies.size() == detection.observers) {
+            last_sum += latencies.back();
+            lasts++;
+        }
+    }
+    const double unmeasured = std::numeric_limits<double>::quiet_NaN();
+    result.first_detection_ms = firsts ? first_sum / firsts : unmeasured;
+    result.median_detection_ms = medians ? median_sum / medians : unmeasured;
+    result.last_detection_ms = lasts ? last_sum / lasts : unmeasured;
+    
+    // Close the open intervals at now without touching the running totals
+    int64_t wrong = wrong_ms;
+    size_t mistakes = closed_mistakes;
+    int64_t mistake_ms = closed_mistake_ms;
+    for (const auto& [k, pair] : pairs) {
+        if (pair.wrong_since >= 0) {
+            wrong += now_ms - pair.wrong_since;
+            if (pair.false_positive) {
+                mistakes++;
+                mistake_ms += now_ms - pair.wrong_since;
+            }
+        }
+    }
+    int64_t uptime = closed_uptime_ms;
+    for (const auto& [id, member] : members) {
+        if (member.up) {
+            uptime += (now_ms - member.up_since) * static_cast<int64_t>(observers_of(id));
+        }
+    }
+    
+    result.mistake_rate = uptime > 0 ? false_positives / (uptime / 1000.0) : 0.0;
+    result.mean_mistake_ms = mistakes ? static_cast<double>(mistake_ms) / mistakes : 0.0;
+    result.mean_recurrence_ms = recurrences ? static_cast<double>(recurrence_ms) / recurrences : 0.0;
+    result.query_accuracy = uptime > 0 ? 1.0 - static_cast<double>(wrong) / uptime : 1.0;
+    result.mean_recovery_ms = recovery_clears ? static_cast<double>(recovery_ms) / recovery_clears : 0.0;
+    return result;
+}
+
+std::vector<AccuracyOracle::Detection> AccuracyOracle::get_detections() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return detections;
+}
@@ -0,0 +1,177 @@
+#include "batch_runner.hpp"
+#include "worker_pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+
+namespace {
+// Two-sided 95% Student's t critical values for 1..30 degrees of freedom
+const double t_critical[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+double percentile(const std::vector<double>& sorted, double fraction) {
+    // Nearest-rank
+    size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+    return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+}
+
+BatchRunner::BatchRunner(size_t threads) : num_threads(std::max<size_t>(threads, 1)) {}
+
+Simulator::TestResult BatchRunner::run_job(const Job& job) {
+    Simulator simulator(Simulator::ExecutionMode::VirtualTime);
+    simulator.set_seed(job.seed);
+    
+    switch (job.scenario) {
+        case Scenario::SingleNodeFailure:
+            return simulator.run_single_node_failure_test(job.num_nodes);
+        case Scenario::MultipleFailures:
+            return simulator.run_multiple_failures_test(job.num_nodes, job.num_nodes / 2);
+        case Scenario::NetworkPartition:
+            return simulator.run_network_partition_test(job.num_nodes);
+        case Scenario::HighLoad:
+            return simulator.run_high_load_test(job.num_nodes);
+        case Scenario::Recovery:
+            return simulator.run_recovery_test(job.num_nodes);
+    }
+    return Simulator::TestResult{};
+}
+
+std::vector<Simulator::TestResult> BatchRunner::run_jobs(const std::vector<Job>& jobs) {
+    std::vector<std::function<Simulator::TestResult()>> tasks;
+    for (const auto& job : jobs) {
+        tasks.push_back([&job]() { return run_job(job); });
+    }
+    return run_tasks(tasks);
+}
+
+std::vector<Simulator::TestResult> BatchRunner::run_tasks(
+    const std::vector<std::function<Simulator::TestResult()>>& tasks) {
+    std::vector<Simulator::TestResult> results(tasks.size());
+    std::mutex done_mutex;
+    std::condition_variable done_cv;
+    size_t remaining = tasks.size();
+    if (tasks.empty()) {
+        return results;
+    }
+    
+    // Each task is a whole virtual-time run; the pool just keeps every core busy
+    WorkerPool pool(std::min(num_threads, tasks.size()));
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        pool.submit([&, i]() {
+            results[i] = tasks[i]();
+            std::lock_guard<std::mutex> lock(done_mutex);
+            if (--remaining == 0) {
+                done_cv.notify_one();
+            }
+        });
+    }
+    
+    std::unique_lock<std::mutex> lock(done_mutex);
+    done_cv.wait(lock, [&]() { return remaining == 0; });
+    lock.unlock();
+    pool.shutdown();
+    return results;
+}
+
+std::vector<BatchRunner::Aggregate> BatchRunner::run(const std::vector<Scenario>& scenarios,
+                                                     const std::vector<int>& sizes, int seeds,
+                                                     uint64_t base_seed) {
+    std::vector<Job> jobs;
+    if (seeds <= 0) {
+        return {};
+    }
+    for (Scenario scenario : scenarios) {
+        for (int size : sizes) {
+            for (int seed = 0; seed < seeds; ++seed) {
+                jobs.push_back({scenario, size, base_seed + static_cast<uint64_t>(seed)});
+            }
+        }
+    }
+    auto results = run_jobs(jobs);
+    
+    // Jobs were generated grouped by (scenario, size), so each group is a contiguous run
+    std::vector<Aggregate> aggregates;
+    for (size_t start = 0; start < jobs.size(); start += static_cast<size_t>(seeds)) {
+        std::vector<double> detection, messages, accuracy;
+        for (size_t i = start; i < start + static_cast<size_t>(seeds); ++i) {
+            if (!std::isnan(results[i].detection_time_ms)) {
+                detection.push_back(results[i].detection_time_ms);  // Runs without a detection have no latency
+            }
+            messages.push_back(results[i].messages_sent);
+            accuracy.push_back(results[i].accuracy);
+        }
+        aggregates.push_back({jobs[start].scenario, jobs[start].num_nodes, summarize(std::move(detection)),
+                              summarize(std::move(messages)), summarize(std::move(accuracy))});
+    }
+    return aggregates;
+}
+
+BatchRunner::Summary BatchRunner::summarize(std::vector<double> samples) {
+    Summary summary{samples.size(), 0, 0, 0, 0, 0};
+    if (samples.empty()) {
+        return summary;
+    }
+    
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    summary.mean = sum / samples.size();
+    summary.p50 = percentile(samples, 0.50);
+    summary.p99 = percentile(samples, 0.99);
+    
+    double half_width = 0;
+    if (samples.size() > 1) {
+        double squares = 0;
+        for (double sample : samples) {
+            squares += (sample - summary.mean) * (sample - summary.mean);
+        }
+        double stddev = std::sqrt(squares / (samples.size() - 1));
+        size_t df = samples.size() - 1;
+        double t = df <= 30 ? t_critical[df - 1] : 1.96;
+        half_width = t * stddev / std::sqrt(static_cast<double>(samples.size()));
+    }
+    summary.ci_low = summary.mean - half_width;
+    summary.ci_high = summary.mean + half_width;
+    return summary;
+}
+
+const char* BatchRunner::scenario_name(Scenario scenario) {
+    switch (scenario) {
+        case Scenario::SingleNodeFailure: return "Single Node Failure";
+        case Scenario::MultipleFailures: return "Multiple Failures";
+        case Scenario::NetworkPartition: return "Network Partition";
+        case Scenario::HighLoad: return "High Load";
+        case Scenario::Recovery: return "Recovery";
+    }
+    return "Unknown";
+}
+
+void BatchRunner::print(const std::vector<Aggregate>& aggregates) {
+    auto print_summary = [](const char* label, const Summary& summary) {
+        if (summary.samples == 0) {
+            std::cout << "  " << std::left << std::setw(16) << label << std::right << "n/a\n";
+            return;
+        }
+        std::cout << "  " << std::left << std::setw(16) << label << std::right << std::fixed << std::setprecision(2)
+                  << "mean " << summary.mean << " [" << summary.ci_low << ", " << summary.ci_high << "]"
+                  << "  p50 " << summary.p50 << "  p99 " << summary.p99 << "\n";
+    };
+    
+    for (const auto& aggregate : aggregates) {
+        std::cout << scenario_name(aggregate.scenario) << ", " << aggregate.num_nodes << " nodes ("
+                  << aggregate.messages_sent.samples << " seeds)\n";
+        print_summary("Detection (ms)", aggregate.detection_time_ms);
+        print_summary("Messages", aggregate.messages_sent);
+        print_summary("Accuracy", aggregate.accuracy);
+    }
+    std::cout.unsetf(std::ios::floatfield);
+}
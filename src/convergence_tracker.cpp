@@ -0,0 +1,160 @@
+#include "convergence_tracker.hpp"
+
+size_t ConvergenceTracker::expected(const Subject& subject) const {
+    return live_observers - (subject.observer && subject.up ? 1 : 0);
+}
+
+bool ConvergenceTracker::is_split(const Subject& subject) const {
+    return subject.suspected_by > 0 && subject.suspected_by < expected(subject);
+}
+
+void ConvergenceTracker::adjust(Subject& subject, int delta, int64_t now_ms) {
+    bool was_split = is_split(subject);
+    size_t before = subject.suspected_by;
+    subject.suspected_by = static_cast<size_t>(static_cast<int64_t>(before) + delta);
+    
+    if (before == 0 && subject.suspected_by > 0) {
+        subject.first_suspected_ms = now_ms;
+    } else if (subject.suspected_by == 0) {
+        subject.first_suspected_ms = -1;
+    }
+    size_t target = expected(subject);
+    if (target > 0 && subject.suspected_by >= target) {
+        if (subject.agreed_ms < 0) {
+            subject.agreed_ms = now_ms;
+        }
+    } else {
+        subject.agreed_ms = -1;
+    }
+    
+    bool split = is_split(subject);
+    if (split && !was_split) {
+        split_subjects++;
+    } else if (!split && was_split && --split_subjects == 0) {
+        converged_ms = now_ms;
+    }
+}
+
+void ConvergenceTracker::recount(int64_t now_ms) {
+    size_t was_split = split_subjects;
+    split_subjects = 0;
+    for (auto& entry : subjects) {
+        Subject& subject = entry.second;
+        size_t target = expected(subject);
+        if (target > 0 && subject.suspected_by >= target) {
+            if (subject.agreed_ms < 0) {
+                subject.agreed_ms = now_ms;
+            }
+        } else {
+            subject.agreed_ms = -1;
+        }
+        if (subject.suspected_by == 0) {
+            subject.first_suspected_ms = -1;
+        }
+        split_subjects += is_split(subject) ? 1 : 0;
+    }
+    if (was_split > 0 && split_subjects == 0) {
+        converged_ms = now_ms;
+    }
+}
+
+void ConvergenceTracker::reset(int64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex);
+    subjects.clear();
+    suspicions.clear();
+    live_observers = 0;
+    split_subjects = 0;
+    converged_ms = now_ms;
+}
+
+void ConvergenceTracker::add_member(NodeId id, bool observer, int64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!subjects.emplace(id, Subject{observer, true}).second) {
+        return;
+    }
+    if (observer) {
+        live_observers++;
+        // Only needed if views were already reported; a fresh cluster has no suspicions yet
+        if (!suspicions.empty()) {
+            recount(now_ms);
+        }
+    }
+}
+
+void ConvergenceTracker::record_crash(NodeId id, int64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = subjects.find(id);
+    if (it == subjects.end() || !it->second.up) {
+        return;
+    }
+    it->second.up = false;
+    if (it->second.observer) {
+        live_observers--;
+        for (NodeId subject : suspicions[id]) {
+            subjects[subject].suspected_by--;
+        }
+    }
+    recount(now_ms);
+}
+
+void ConvergenceTracker::record_recovery(NodeId id, int64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = subjects.find(id);
+    if (it == subjects.end() || it->second.up) {
+        return;
+    }
+    it->second.up = true;
+    if (it->second.observer) {
+        live_observers++;
+        for (NodeId subject : suspicions[id]) {
+            auto& target = subjects[subject];
+            if (target.suspected_by++ == 0) {
+                target.first_suspected_ms = now_ms;
+            }
+        }
+    }
+    recount(now_ms);
+}
+
+void ConvergenceTracker::on_view_change(NodeId observer, NodeId subject, bool suspected, int64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto watcher = subjects.find(observer);
+    auto target = subjects.find(subject);
+    if (watcher == subjects.end() || target == subjects.end() || !watcher->second.observer) {
+        return;
+    }
+    auto& suspects = suspicions[observer];
+    bool changed = suspected ? suspects.insert(subject).second : suspects.erase(subject) > 0;
+    // A crashed observer's view is kept for when it recovers but does not count meanwhile
+    if (changed && watcher->second.up) {
+        adjust(target->second, suspected ? 1 : -1, now_ms);
+    }
+}
+
+bool ConvergenceTracker::is_converged() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return split_subjects == 0;
+}
+
+int64_t ConvergenceTracker::get_converged_ms() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return converged_ms;
+}
+
+int64_t ConvergenceTracker::get_first_suspected_ms(NodeId id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = subjects.find(id);
+    return it != subjects.end() ? it->second.first_suspected_ms : -1;
+}
+
+int64_t ConvergenceTracker::get_agreed_ms(NodeId id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = subjects.find(id);
+    return it != subjects.end() ? it->second.agreed_ms : -1;
+}
+
+size_t ConvergenceTracker::get_suspected_by(NodeId id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = subjects.find(id);
+    return it != subjects.end() ? it->second.suspected_by : 0;
+}
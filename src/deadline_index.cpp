@@ -0,0 +1,91 @@
+#include "deadline_index.hpp"
+
+void DeadlineIndex::set(NodeId id, int64_t deadline) {
+    if (id >= positions.size()) {
+        positions.resize(static_cast<size_t>(id) + 1, npos);
+    }
+
+    if (positions[id] == npos) {
+        heap.push_back({deadline, id});
+        positions[id] = static_cast<uint32_t>(heap.size() - 1);
+        sift_up(heap.size() - 1);
+        return;
+    }
+
+    // Heartbeats usually push a deadline later, so most updates sift down
+    size_t slot = positions[id];
+    int64_t previous = heap[slot].deadline;
+    heap[slot].deadline = deadline;
+    if (deadline < previous) {
+        sift_up(slot);
+    } else {
+        sift_down(slot);
+    }
+}
+
+bool DeadlineIndex::remove(NodeId id) {
+    if (!contains(id)) {
+        return false;
+    }
+    erase_slot(positions[id]);
+    return true;
+}
+
+void DeadlineIndex::clear() {
+    heap.clear();
+    positions.clear();
+}
+
+void DeadlineIndex::place(size_t slot, const Entry& entry) {
+    heap[slot] = entry;
+    positions[entry.id] = static_cast<uint32_t>(slot);
+}
+
+void DeadlineIndex::erase_slot(size_t slot) {
+    positions[heap[slot].id] = npos;
+    Entry last = heap.back();
+    heap.pop_back();
+    if (slot == heap.size()) {
+        return;
+    }
+
+    place(slot, last);
+    if (slot > 0 && heap[slot].deadline < heap[(slot - 1) / 2].deadline) {
+        sift_up(slot);
+    } else {
+        sift_down(slot);
+    }
+}
+
+void DeadlineIndex::sift_up(size_t slot) {
+    Entry entry = heap[slot];
+    while (slot > 0) {
+        size_t parent = (slot - 1) / 2;
+        if (heap[parent].deadline <= entry.deadline) {
+            break;
+        }
+        place(slot, heap[parent]);
+        slot = parent;
+    }
+    place(slot, entry);
+}
+
+void DeadlineIndex::sift_down(size_t slot) {
+    Entry entry = heap[slot];
+    size_t count = heap.size();
+    while (true) {
+        size_t child = 2 * slot + 1;
+        if (child >= count) {
+            break;
+        }
+        if (child + 1 < count && heap[child + 1].deadline < heap[child].deadline) {
+            child++;
+        }
+        if (entry.deadline <= heap[child].deadline) {
+            break;
+        }
+        place(slot, heap[child]);
+        slot = child;
+    }
+    place(slot, entry);
+}
@@ -0,0 +1,89 @@
+#include "envelope_pool.hpp"
+
+EnvelopePool& EnvelopePool::instance() {
+    static EnvelopePool pool;
+    return pool;
+}
+
+EnvelopePool::LocalCache& EnvelopePool::local_cache() {
+    thread_local LocalCache cache;
+    return cache;
+}
+
+EnvelopePool::LocalCache::~LocalCache() {
+    // Hand a finished thread's envelopes back to everyone else
+    if (head) {
+        instance().spill(*this, 0);
+    }
+}
+
+Envelope* EnvelopePool::acquire(uint64_t& allocations) {
+    LocalCache& cache = local_cache();
+    if (!cache.head) {
+        refill(cache, allocations);
+    }
+    Envelope* envelope = cache.head;
+    cache.head = envelope->next;
+    cache.count--;
+    envelope->next = nullptr;
+    return envelope;
+}
+
+void EnvelopePool::release(Envelope* envelope) {
+    LocalCache& cache = local_cache();
+    envelope->content.clear();  // Keeps the capacity for the next sender
+    envelope->next = cache.head;
+    cache.head = envelope;
+    if (++cache.count > local_limit) {
+        spill(cache, local_limit - transfer_batch);
+    }
+}
+
+void EnvelopePool::refill(LocalCache& cache, uint64_t& allocations) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!shared_head) {
+        slabs.push_back(std::make_unique<Envelope[]>(slab_size));
+        slab_allocations++;
+        allocations++;
+        Envelope* slab = slabs.back().get();
+        for (size_t i = 0; i < slab_size; ++i) {
+            // Pay for typical payload buffers up front so no envelope allocates on first use
+            slab[i].content.reserve(initial_content_bytes);
+            allocations++;
+            slab[i].next = shared_head;
+            shared_head = &slab[i];
+        }
+        shared_count += slab_size;
+    }
+
+    for (size_t moved = 0; moved < transfer_batch && shared_head; ++moved) {
+        Envelope* envelope = shared_head;
+        shared_head = envelope->next;
+        shared_count--;
+        envelope->next = cache.head;
+        cache.head = envelope;
+        cache.count++;
+    }
+}
+
+void EnvelopePool::spill(LocalCache& cache, size_t keep) {
+    std::lock_guard<std::mutex> lock(mutex);
+    while (cache.count > keep) {
+        Envelope* envelope = cache.head;
+        cache.head = envelope->next;
+        cache.count--;
+        envelope->next = shared_head;
+        shared_head = envelope;
+        shared_count++;
+    }
+}
+
+uint64_t EnvelopePool::get_slab_allocations() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return slab_allocations;
+}
+
+size_t EnvelopePool::get_capacity() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return slabs.size() * slab_size;
+}
@@ -0,0 +1,67 @@
+#include "event_scheduler.hpp"
+#include <algorithm>
+
+EventScheduler::EventScheduler(TimePoint start_time)
+    : current_time(start_time), next_seq(0), executed_events(0) {}
+
+EventScheduler::TimePoint EventScheduler::now() const {
+    std::lock_guard<std::mutex> lock(events_mutex);
+    return current_time;
+}
+
+void EventScheduler::schedule_at(TimePoint when, Callback callback) {
+    std::lock_guard<std::mutex> lock(events_mutex);
+    // Events can never fire in the past
+    events.push({std::max(when, current_time), next_seq++, std::move(callback)});
+}
+
+bool EventScheduler::pop_due_event(TimePoint deadline, Event& out) {
+    std::lock_guard<std::mutex> lock(events_mutex);
+    if (events.empty() || events.top().time > deadline) {
+        return false;
+    }
+    out = events.top();
+    events.pop();
+    current_time = out.time;
+    executed_events++;
+    return true;
+}
+
+bool EventScheduler::run_next() {
+    Event event;
+    if (!pop_due_event(TimePoint::max(), event)) {
+        return false;
+    }
+    // Run outside the lock so callbacks can schedule follow-up events
+    event.callback();
+    return true;
+}
+
+void EventScheduler::run_until(TimePoint deadline) {
+    Event event;
+    while (pop_due_event(deadline, event)) {
+        event.callback();
+    }
+
+    std::lock_guard<std::mutex> lock(events_mutex);
+    current_time = std::max(current_time, deadline);
+}
+
+void EventScheduler::run_for(int duration_ms) {
+    run_until(now() + std::chrono::milliseconds(std::max(0, duration_ms)));
+}
+
+void EventScheduler::clear() {
+    std::lock_guard<std::mutex> lock(events_mutex);
+    events = std::priority_queue<Event>();
+}
+
+size_t EventScheduler::pending_events() const {
+    std::lock_guard<std::mutex> lock(events_mutex);
+    return events.size();
+}
+
+uint64_t EventScheduler::get_executed_events() const {
+    std::lock_guard<std::mutex> lock(events_mutex);
+    return executed_events;
+}
@@ -0,0 +1,100 @@
+#include "gossip_codec.hpp"
+
+void put_varint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool get_varint(std::string_view in, size_t& pos, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= in.size()) {
+            return false;
+        }
+        uint8_t byte = static_cast<uint8_t>(in[pos++]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;  // More than 10 bytes: not a valid 64-bit varint
+}
+
+size_t varint_size(uint64_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+void put_fixed(std::string& out, uint64_t value, size_t bytes) {
+    for (size_t byte = 0; byte < bytes; ++byte) {
+        out.push_back(static_cast<char>((value >> (8 * byte)) & 0xFF));
+    }
+}
+
+bool get_fixed(std::string_view in, size_t& pos, uint64_t& value, size_t bytes) {
+    if (pos > in.size() || in.size() - pos < bytes) {
+        return false;
+    }
+    value = 0;
+    for (size_t byte = 0; byte < bytes; ++byte) {
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(in[pos++])) << (8 * byte);
+    }
+    return true;
+}
+
+GossipEncoder::GossipEncoder(std::string& buffer) : out(buffer) {
+    out.clear();
+    out.push_back(static_cast<char>(magic));
+    out.push_back(static_cast<char>(format_version));
+}
+
+void GossipEncoder::add(const GossipEntry& entry) {
+    for (size_t byte = 0; byte < GossipEncoder::id_size; ++byte) {
+        out.push_back(static_cast<char>((entry.id >> (8 * byte)) & 0xFF));
+    }
+    out.push_back(static_cast<char>(entry.is_alive ? 1 : 0));
+    put_varint(out, entry.version);
+}
+
+size_t GossipEncoder::encoded_size(const GossipEntry& entry) {
+    return id_size + 1 + varint_size(entry.version);
+}
+
+GossipDecoder::GossipDecoder(std::string_view buffer)
+    : data(buffer), pos(GossipEncoder::header_size), error(false) {
+    if (data.size() < GossipEncoder::header_size ||
+        static_cast<uint8_t>(data[0]) != GossipEncoder::magic ||
+        static_cast<uint8_t>(data[1]) != GossipEncoder::format_version) {
+        error = true;
+    }
+}
+
+bool GossipDecoder::next(GossipEntry& entry) {
+    if (error || pos >= data.size()) {
+        return false;
+    }
+
+    // Fixed-width id plus the flags byte
+    if (data.size() - pos < GossipEncoder::id_size + 1) {
+        error = true;
+        return false;
+    }
+    entry.id = 0;
+    for (size_t byte = 0; byte < GossipEncoder::id_size; ++byte) {
+        entry.id |= static_cast<NodeId>(static_cast<uint8_t>(data[pos++])) << (8 * byte);
+    }
+    entry.is_alive = (static_cast<uint8_t>(data[pos++]) & 1) != 0;
+
+    if (!get_varint(data, pos, entry.version)) {
+        error = true;
+        return false;
+    }
+    return true;
+}
@@ -1,30 +1,32 @@
 #include "gossip_node.hpp"
-#include <sstream>
+#include "gossip_codec.hpp"
 #include <algorithm>
 #include <chrono>
 
-GossipNode::GossipNode(const std::string& node_id, const std::vector<std::string>& peer_ids)
-    : Node(node_id), rng(std::random_device{}()) {
+GossipNode::GossipNode(const std::string& node_id, const std::vector<std::string>& peer_ids,
+                       std::shared_ptr<TaskScheduler> task_scheduler)
+    : Node(node_id, std::move(task_scheduler)), sampler(numeric_id), rng(std::random_device{}()) {
+    members.set_flip_handler([this](NodeId subject, bool failed) {
+        ++update_seq;
+        refresh_entry(subject);  // Liveness is part of the anti-entropy digest
+        report_view_change(subject, failed);
+    });
     
     // Initialize node states
+    auto& registry = NodeRegistry::instance();
     for (const auto& peer_id : peer_ids) {
-        node_states[peer_id] = {true, get_current_time(), 0};
+        add_member(registry.intern(peer_id));
     }
-    node_states[node_id] = {true, get_current_time(), 0};  // Add self
+    add_member(numeric_id);  // Add self
     
     // Initialize metrics
     metrics = {0, 0, 0, 0, get_current_time()};
-}
-
-void GossipNode::start() {
-    is_running = true;
-    node_thread = std::thread(&GossipNode::run, this);
+    last_gossip = get_current_time();
 }
 
 void GossipNode::send_message(const std::string& to_id, const std::string& content) {
-    // In a real implementation, this would send over the network
-    // For simulation, we'll just increment the message counter
     metrics.messages_sent++;
+    transmit(NodeRegistry::instance().intern(to_id), content);
 }
 
 void GossipNode::process_message(const Message& msg) {
@@ -33,131 +35,395 @@ void GossipNode::process_message(const Message& msg) {
     // Update sender's state
     {
         std::lock_guard<std::mutex> lock(states_mutex);
-        auto it = node_states.find(msg.from_id);
-        if (it != node_states.end()) {
-            it->second.last_seen = msg.timestamp;
-            it->second.suspicion_level = 0;
-            it->second.is_alive = true;  // Reset alive status when we hear from a node
+        if (members.contains(msg.from_id)) {
+            // Reset alive status when we hear from a node
+            members.mark_seen(msg.from_id, std::chrono::duration_cast<std::chrono::milliseconds>(
+                msg.timestamp.time_since_epoch()).count());
         }
     }
     
+    if (!msg.content.empty() && static_cast<uint8_t>(msg.content[0]) == anti_entropy_magic) {
+        handle_anti_entropy(msg.content, msg.from_id);
+        return;
+    }
+    
     // Process the gossip state
-    deserialize_state(msg.content);
+    deserialize_state(msg.content, msg.from_id);
 }
 
 void GossipNode::periodic_task() {
-    static auto last_gossip = get_current_time();
     auto now = get_current_time();
     
     if (std::chrono::duration_cast<std::chrono::milliseconds>(now - last_gossip).count() >= gossip_interval_ms) {
         gossip_round();
         last_gossip = now;
         
-        // Update suspicion levels
+        // Update suspicion levels (linear pass over the table, self excluded)
         std::lock_guard<std::mutex> lock(states_mutex);
-        for (auto& [id, state] : node_states) {
-            if (id != this->id) {  // Don't check self
-                auto time_since_last_seen = std::chrono::duration_cast<std::chrono::milliseconds>(
-                    now - state.last_seen).count();
-                
-                if (time_since_last_seen > gossip_interval_ms) {
-                    state.suspicion_level++;
-                    if (state.suspicion_level >= suspicion_threshold) {
-                        state.is_alive = false;
-                    }
-                }
-            }
-        }
+        int stale_after_ms = anti_entropy ? gossip_interval_ms * (epoch_rounds + 1) : gossip_interval_ms;
+        members.advance_suspicion(numeric_id, get_current_time_ms(), stale_after_ms, suspicion_threshold);
     }
 }
 
 void GossipNode::gossip_round() {
-    auto peers = select_random_peers();
-    std::string state_str;
-    serialize_state(state_str);
+    const auto& peers = select_peers();
     
-    for (const auto& peer : peers) {
-        send_message(peer, state_str);
+    // Bump our own heartbeat so peers can tell we are still making progress
+    {
+        std::lock_guard<std::mutex> lock(states_mutex);
+        members.mark_seen(numeric_id, get_current_time_ms());
+        versions[numeric_id]++;
+        updated_seqs[numeric_id] = ++update_seq;
+        refresh_entry(numeric_id);
     }
-}
-
-std::vector<std::string> GossipNode::select_random_peers() {
-    std::vector<std::string> peers;
-    std::lock_guard<std::mutex> lock(states_mutex);
     
-    // Get all peer IDs
-    for (const auto& [id, state] : node_states) {
-        if (id != this->id) {  // Don't include self
-            peers.push_back(id);
+    if (anti_entropy) {
+        // Only the root goes out; a peer that differs answers and the exchange descends from there
+        {
+            std::lock_guard<std::mutex> lock(states_mutex);
+            encode_root(gossip_buffer);
         }
+        for (NodeId peer : peers) {
+            metrics.messages_sent++;
+            transmit(peer, gossip_buffer);
+        }
+        return;
     }
     
-    // Randomly select fanout number of peers
-    if (peers.size() <= fanout) {
-        return peers;
+    if (!delta_gossip) {
+        serialize_state(gossip_buffer);
+        for (NodeId peer : peers) {
+            metrics.messages_sent++;
+            transmit(peer, gossip_buffer);
+        }
+        return;
     }
     
-    std::shuffle(peers.begin(), peers.end(), rng);
-    return std::vector<std::string>(peers.begin(), peers.begin() + fanout);
+    for (NodeId peer : peers) {
+        size_t full_state_bytes = serialize_delta(peer, gossip_buffer);
+        metrics.messages_sent++;
+        transmit(peer, gossip_buffer, full_state_bytes);
+    }
+}
+
+const std::vector<NodeId>& GossipNode::select_peers() {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    const auto& picks = sampler.select(static_cast<size_t>(fanout), rng);
+    round_peers.assign(picks.begin(), picks.end());
+    return round_peers;
+}
+
+void GossipNode::set_timing(int interval_ms, int missed_rounds, int peers_per_round) {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    gossip_interval_ms = std::max(1, interval_ms);
+    suspicion_threshold = std::max(1, missed_rounds);
+    fanout = std::max(1, peers_per_round);
 }
 
-void GossipNode::update_node_state(const std::string& node_id, bool is_alive) {
+void GossipNode::set_peer_sampling(PeerSampler::Strategy strategy) {
     std::lock_guard<std::mutex> lock(states_mutex);
-    auto it = node_states.find(node_id);
-    if (it != node_states.end()) {
-        it->second.is_alive = is_alive;
-        it->second.last_seen = get_current_time();
-        it->second.suspicion_level = 0;
+    sampler.set_strategy(strategy);
+}
+
+void GossipNode::set_zone(NodeId member, int zone) {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    sampler.set_zone(member, zone);
+}
+
+void GossipNode::add_member(NodeId member_id) {
+    members.add(member_id, get_current_time_ms());
+    sampler.add(member_id);
+    if (member_id >= versions.size()) {
+        size_t new_size = static_cast<size_t>(member_id) + 1;
+        versions.resize(new_size, 0);
+        updated_seqs.resize(new_size, 0);
+        learned_from.resize(new_size, invalid_node_id);
+        peer_sync.resize(new_size, PeerSync{false, 0, 0});
+        entry_hashes.resize(new_size, 0);
+    }
+    versions[member_id] = 0;
+    updated_seqs[member_id] = ++update_seq;
+    learned_from[member_id] = invalid_node_id;
+    peer_sync[member_id] = PeerSync{false, 0, 0};
+    refresh_entry(member_id);
+}
+
+void GossipNode::update_node_state(NodeId node_id, bool is_alive) {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    if (members.contains(node_id)) {
+        members.mark_seen(node_id, get_current_time_ms());
+        members.set_alive(node_id, is_alive);
     }
 }
 
 std::vector<std::string> GossipNode::get_failed_nodes() const {
     std::vector<std::string> failed;
-    std::lock_guard<std::mutex> lock(states_mutex);
-    
-    for (const auto& [id, state] : node_states) {
-        if (!state.is_alive || state.suspicion_level >= suspicion_threshold) {
-            failed.push_back(id);
-        }
+    auto& registry = NodeRegistry::instance();
+    for (NodeId node_id : get_failed_node_ids()) {
+        failed.push_back(registry.name(node_id));
     }
-    
     return failed;
 }
 
+std::vector<NodeId> GossipNode::get_failed_node_ids() const {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    return members.collect_failed(suspicion_threshold);
+}
+
+bool GossipNode::is_node_failed(NodeId node_id) const {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    return members.contains(node_id) &&
+           (!members.is_alive(node_id) || members.get_suspicion(node_id) >= suspicion_threshold);
+}
+
 void GossipNode::serialize_state(std::string& out) const {
-    std::stringstream ss;
+    // Encodes into the caller's buffer, so a reused buffer stops allocating after warm-up
+    GossipEncoder encoder(out);
     std::lock_guard<std::mutex> lock(states_mutex);
     
-    for (const auto& [id, state] : node_states) {
-        ss << id << ":" << state.is_alive << ":" 
-           << std::chrono::system_clock::to_time_t(state.last_seen) << ";";
+    for (NodeId member : members.get_members()) {
+        encoder.add({member, members.is_alive(member), versions[member]});
     }
+}
+
+size_t GossipNode::serialize_delta(NodeId peer_id, std::string& out) {
+    GossipEncoder encoder(out);
+    size_t full_state_bytes = GossipEncoder::header_size;
+    std::lock_guard<std::mutex> lock(states_mutex);
     
-    out = ss.str();
+    if (peer_id >= peer_sync.size()) {
+        peer_sync.resize(static_cast<size_t>(peer_id) + 1, PeerSync{false, 0, 0});
+    }
+    auto& sync = peer_sync[peer_id];
+    
+    // New peers and peers overdue for a resync get everything; lost deltas are never
+    // retransmitted, so the periodic full state is what repairs a drifted peer
+    bool send_full = !sync.known || sync.deltas_since_full >= full_sync_interval;
+    
+    for (NodeId member : members.get_members()) {
+        GossipEntry entry{member, members.is_alive(member), versions[member]};
+        full_state_bytes += GossipEncoder::encoded_size(entry);
+        
+        bool changed = updated_seqs[member] > sync.last_sent_seq;
+        bool peer_has_it = learned_from[member] == peer_id;  // We heard this version from them
+        if (send_full || (changed && !peer_has_it)) {
+            encoder.add(entry);
+        }
+    }
+    
+    sync.known = true;
+    sync.last_sent_seq = update_seq;
+    sync.deltas_since_full = send_full ? 0 : sync.deltas_since_full + 1;
+    return full_state_bytes;
 }
 
-void GossipNode::deserialize_state(const std::string& in) {
-    std::stringstream ss(in);
-    std::string entry;
+void GossipNode::deserialize_state(std::string_view in, NodeId from_id) {
+    GossipDecoder decoder(in);
+    GossipEntry entry;
+    auto now_ms = get_current_time_ms();
     
-    while (std::getline(ss, entry, ';')) {
-        std::stringstream entry_ss(entry);
-        std::string id, is_alive_str, timestamp_str;
+    // One lock for the whole message instead of one per entry
+    std::lock_guard<std::mutex> lock(states_mutex);
+    while (decoder.next(entry)) {
+        if (!members.contains(entry.id) || entry.version <= versions[entry.id]) {
+            continue;  // Unknown node or nothing newer than what we have
+        }
         
-        if (std::getline(entry_ss, id, ':') &&
-            std::getline(entry_ss, is_alive_str, ':') &&
-            std::getline(entry_ss, timestamp_str, ':')) {
-            
-            bool is_alive = (is_alive_str == "1");
-            time_t timestamp = std::stoll(timestamp_str);
-            
+        // A newer heartbeat means the origin was alive when it produced it
+        members.mark_seen(entry.id, now_ms);
+        versions[entry.id] = entry.version;
+        updated_seqs[entry.id] = ++update_seq;
+        learned_from[entry.id] = from_id;
+        refresh_entry(entry.id);
+    }
+}
+
+void GossipNode::set_anti_entropy(bool enabled, int rounds_per_epoch) {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    anti_entropy = enabled;
+    epoch_rounds = std::max(1, rounds_per_epoch);
+    if (anti_entropy) {
+        rebuild_digest();  // Entry hashes depend on the epoch length
+    }
+}
+
+void GossipNode::rebuild_digest() {
+    std::fill(entry_hashes.begin(), entry_hashes.end(), 0);
+    digest.clear();
+    for (NodeId member : members.get_members()) {
+        uint64_t epoch = versions[member] / static_cast<uint64_t>(epoch_rounds);
+        entry_hashes[member] = MerkleDigest::entry_hash(member, members.is_alive(member), epoch);
+        digest.add(member, entry_hashes[member]);
+    }
+    digest.build();
+}
+
+void GossipNode::refresh_entry(NodeId member) {
+    if (!anti_entropy || member >= entry_hashes.size()) {
+        return;
+    }
+    uint64_t hash = 0;
+    if (members.contains(member)) {
+        uint64_t epoch = versions[member] / static_cast<uint64_t>(epoch_rounds);
+        hash = MerkleDigest::entry_hash(member, members.is_alive(member), epoch);
+    }
+    // Most heartbeats stay inside their epoch and leave the digest untouched
+    if (hash != entry_hashes[member]) {
+        digest.toggle(member, entry_hashes[member] ^ hash);
+        entry_hashes[member] = hash;
+    }
+}
+
+void GossipNode::encode_root(std::string& out) {
+    out.clear();
+    out.push_back(static_cast<char>(anti_entropy_magic));
+    out.push_back(static_cast<char>(AntiEntropyKind::Root));
+    put_varint(out, static_cast<uint64_t>(digest.get_depth()));
+    put_fixed(out, digest.get(digest.get_depth(), 0), 8);
+}
+
+void GossipNode::encode_children(std::string& out, int child_level, const std::vector<size_t>& parents) {
+    out.clear();
+    out.push_back(static_cast<char>(anti_entropy_magic));
+    out.push_back(static_cast<char>(AntiEntropyKind::Children));
+    put_varint(out, static_cast<uint64_t>(child_level));
+    for (size_t parent : parents) {
+        put_varint(out, parent);
+        uint64_t mask = 0;
+        for (size_t child = 0; child < MerkleDigest::fanout; ++child) {
+            if (digest.get(child_level, parent * MerkleDigest::fanout + child) != 0) {
+                mask |= uint64_t{1} << child;
+            }
+        }
+        put_fixed(out, mask, 2);
+        for (size_t child = 0; child < MerkleDigest::fanout; ++child) {
+            if (mask & (uint64_t{1} << child)) {
+                put_fixed(out, digest.get(child_level, parent * MerkleDigest::fanout + child), 8);
+            }
+        }
+    }
+}
+
+void GossipNode::encode_entries(std::string& out, bool reply_wanted, const std::vector<size_t>& leaves) {
+    out.clear();
+    out.push_back(static_cast<char>(anti_entropy_magic));
+    out.push_back(static_cast<char>(AntiEntropyKind::Entries));
+    out.push_back(static_cast<char>(reply_wanted ? 1 : 0));
+    put_varint(out, leaves.size());
+    for (size_t leaf : leaves) {
+        put_varint(out, leaf);
+    }
+    
+    GossipEncoder encoder(entries_buffer);
+    for (size_t leaf : leaves) {
+        for (size_t offset = 0; offset < MerkleDigest::fanout; ++offset) {
+            NodeId id = static_cast<NodeId>(leaf * MerkleDigest::fanout + offset);
+            if (members.contains(id)) {
+                encoder.add({id, members.is_alive(id), versions[id]});
+            }
+        }
+    }
+    out.append(entries_buffer);
+}
+
+void GossipNode::handle_anti_entropy(std::string_view in, NodeId from_id) {
+    // Deeper than this would need ids wider than 32 bits
+    const uint64_t max_level = 32 / MerkleDigest::fanout_bits - 1;
+    if (in.size() < anti_entropy_header_size || from_id == invalid_node_id) {
+        return;
+    }
+    size_t pos = anti_entropy_header_size;
+    std::string reply;
+    std::string descend;  // Children reply, sent alongside an Entries reply
+    
+    switch (static_cast<AntiEntropyKind>(in[1])) {
+        case AntiEntropyKind::Root: {
+            uint64_t level, hash;
+            if (!get_varint(in, pos, level) || level > max_level || !get_fixed(in, pos, hash, 8)) {
+                return;
+            }
             std::lock_guard<std::mutex> lock(states_mutex);
-            auto it = node_states.find(id);
-            if (it != node_states.end()) {
-                it->second.is_alive = is_alive;
-                it->second.last_seen = std::chrono::system_clock::from_time_t(timestamp);
-                it->second.suspicion_level = 0;
+            int depth = digest.get_depth();
+            int root_level = static_cast<int>(level);
+            if (depth <= root_level && digest.get(root_level, 0) == hash) {
+                return;  // In sync: the whole exchange was one root
+            }
+            int top = std::max(depth, root_level);
+            if (top == 0) {
+                encode_entries(reply, true, {0});
+            } else {
+                encode_children(reply, top - 1, {0});
             }
+            break;
+        }
+        case AntiEntropyKind::Children: {
+            uint64_t level;
+            if (!get_varint(in, pos, level) || level > max_level) {
+                return;
+            }
+            int child_level = static_cast<int>(level);
+            std::vector<size_t> leaves;
+            std::vector<size_t> parents;
+            std::lock_guard<std::mutex> lock(states_mutex);
+            while (pos < in.size()) {
+                uint64_t parent, mask;
+                if (!get_varint(in, pos, parent) || !get_fixed(in, pos, mask, 2) ||
+                    parent > (uint64_t{0xffffffffu} >> (MerkleDigest::fanout_bits * (child_level + 1)))) {
+                    return;
+                }
+                for (size_t child = 0; child < MerkleDigest::fanout; ++child) {
+                    uint64_t theirs = 0;
+                    if ((mask & (uint64_t{1} << child)) && !get_fixed(in, pos, theirs, 8)) {
+                        return;
+                    }
+                    size_t index = static_cast<size_t>(parent) * MerkleDigest::fanout + child;
+                    if (digest.get(child_level, index) != theirs) {
+                        (child_level == 0 ? leaves : parents).push_back(index);
+                    }
+                }
+            }
+            // Differing leaves are pushed with a request for the peer's side; differing
+            // inner nodes go down one more level
+            if (!leaves.empty()) {
+                encode_entries(reply, true, leaves);
+            }
+            if (!parents.empty()) {
+                encode_children(descend, child_level - 1, parents);
+            }
+            break;
+        }
+        case AntiEntropyKind::Entries: {
+            if (in.size() - pos < 1) {
+                return;
+            }
+            bool reply_wanted = (static_cast<uint8_t>(in[pos++]) & 1) != 0;
+            uint64_t count;
+            if (!get_varint(in, pos, count) || count > in.size() - pos) {
+                return;  // Every leaf index takes at least a byte
+            }
+            std::vector<size_t> leaves;
+            for (uint64_t i = 0; i < count; ++i) {
+                uint64_t leaf;
+                if (!get_varint(in, pos, leaf) || leaf > (uint64_t{0xffffffffu} >> MerkleDigest::fanout_bits)) {
+                    return;
+                }
+                leaves.push_back(static_cast<size_t>(leaf));
+            }
+            deserialize_state(in.substr(pos), from_id);
+            if (reply_wanted) {
+                std::lock_guard<std::mutex> lock(states_mutex);
+                encode_entries(reply, false, leaves);
+            }
+            break;
+        }
+        default:
+            return;
+    }
+    
+    for (const std::string* out : {&reply, &descend}) {
+        if (!out->empty()) {
+            metrics.messages_sent++;
+            transmit(from_id, *out);
         }
     }
 }
@@ -172,10 +438,16 @@ void GossipNode::reset_metrics() {
 
 void GossipNode::add_peer(const std::string& peer_id) {
     std::lock_guard<std::mutex> lock(states_mutex);
-    node_states[peer_id] = {true, get_current_time(), 0};
+    add_member(NodeRegistry::instance().intern(peer_id));
 }
 
 void GossipNode::remove_peer(const std::string& peer_id) {
+    NodeId peer = NodeRegistry::instance().find(peer_id);
     std::lock_guard<std::mutex> lock(states_mutex);
-    node_states.erase(peer_id);
-} 
\ No newline at end of file
+    if (members.remove(peer)) {
+        peer_sync[peer] = PeerSync{false, 0, 0};
+        sampler.remove(peer);
+        ++update_seq;
+        refresh_entry(peer);
+    }
+}
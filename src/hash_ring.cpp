@@ -0,0 +1,62 @@
+#include "hash_ring.hpp"
+#include <algorithm>
+
+HashRing::HashRing(size_t virtual_nodes) : virtual_nodes(std::max<size_t>(virtual_nodes, 1)) {}
+
+uint64_t HashRing::hash(uint64_t value) {
+    // splitmix64 finalizer: dense NodeIds need a real mix to spread around the ring
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+void HashRing::add(NodeId monitor) {
+    if (contains(monitor)) {
+        return;
+    }
+    monitors.push_back(monitor);
+    for (size_t replica = 0; replica < virtual_nodes; ++replica) {
+        points.emplace_back(hash((static_cast<uint64_t>(monitor) << 32) | replica), monitor);
+    }
+    std::sort(points.begin(), points.end());
+}
+
+void HashRing::remove(NodeId monitor) {
+    monitors.erase(std::remove(monitors.begin(), monitors.end(), monitor), monitors.end());
+    points.erase(std::remove_if(points.begin(), points.end(),
+                                [monitor](const std::pair<uint64_t, NodeId>& point) {
+                                    return point.second == monitor;
+                                }),
+                 points.end());
+}
+
+bool HashRing::contains(NodeId monitor) const {
+    return std::find(monitors.begin(), monitors.end(), monitor) != monitors.end();
+}
+
+std::vector<NodeId> HashRing::owners(NodeId key, size_t count, const std::vector<NodeId>& excluded) const {
+    std::vector<NodeId> result;
+    if (points.empty()) {
+        return result;
+    }
+
+    // Keys hash into a separate stream from the monitor points
+    uint64_t key_hash = hash(static_cast<uint64_t>(key) | (1ULL << 63));
+    auto start = std::lower_bound(points.begin(), points.end(), std::make_pair(key_hash, NodeId{0}));
+    size_t first = static_cast<size_t>(start - points.begin());
+
+    for (size_t step = 0; step < points.size() && result.size() < count; ++step) {
+        NodeId monitor = points[(first + step) % points.size()].second;
+        if (std::find(result.begin(), result.end(), monitor) == result.end() &&
+            std::find(excluded.begin(), excluded.end(), monitor) == excluded.end()) {
+            result.push_back(monitor);
+        }
+    }
+    return result;
+}
+
+NodeId HashRing::owner(NodeId key) const {
+    auto result = owners(key, 1);
+    return result.empty() ? invalid_node_id : result[0];
+}
@@ -0,0 +1,156 @@
+#include "hdr_histogram.hpp"
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+size_t HdrHistogram::index_of(uint64_t value) {
+    if (value < 32) {
+        return static_cast<size_t>(value);
+    }
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - sub_bucket_bits;  // value >> shift lands in [16, 31]
+    size_t index = 32 + static_cast<size_t>(shift - 1) * 16 + static_cast<size_t>((value >> shift) - 16);
+    return std::min(index, bucket_count - 1);
+}
+
+uint64_t HdrHistogram::lowest_value(size_t index) {
+    if (index < 32) {
+        return index;
+    }
+    size_t shift = (index - 32) / 16 + 1;
+    return (16 + (index - 32) % 16) << shift;
+}
+
+uint64_t HdrHistogram::highest_value(size_t index) {
+    if (index < 32) {
+        return index;
+    }
+    if (index == bucket_count - 1) {
+        return UINT64_MAX;  // Everything larger is clamped into the last bucket
+    }
+    return lowest_value(index + 1) - 1;
+}
+
+HdrHistogram::HdrHistogram() : total(0), min_value(UINT64_MAX), max_value(0), sum(0) {}
+
+void HdrHistogram::record(uint64_t value, uint64_t count) {
+    if (count == 0) {
+        return;
+    }
+    size_t index = index_of(value);
+    if (index >= counts.size()) {
+        counts.resize(index + 1, 0);
+    }
+    counts[index] += count;
+    total += count;
+    min_value = std::min(min_value, value);
+    max_value = std::max(max_value, value);
+    sum += static_cast<long double>(value) * count;
+}
+
+void HdrHistogram::record_bucket(size_t index, uint64_t count) {
+    if (count == 0) {
+        return;
+    }
+    if (index >= counts.size()) {
+        counts.resize(index + 1, 0);
+    }
+    counts[index] += count;
+    total += count;
+    // Only the bucket is known: take its bounds, and its midpoint for the mean
+    uint64_t low = lowest_value(index);
+    uint64_t high = std::max(low, std::min(highest_value(index), low * 2));
+    min_value = std::min(min_value, low);
+    max_value = std::max(max_value, high);
+    sum += (static_cast<long double>(low) + high) / 2 * count;
+}
+
+void HdrHistogram::merge(const HdrHistogram& other) {
+    if (other.total == 0) {
+        return;
+    }
+    if (other.counts.size() > counts.size()) {
+        counts.resize(other.counts.size(), 0);
+    }
+    for (size_t i = 0; i < other.counts.size(); ++i) {
+        counts[i] += other.counts[i];
+    }
+    total += other.total;
+    min_value = std::min(min_value, other.min_value);
+    max_value = std::max(max_value, other.max_value);
+    sum += other.sum;
+}
+
+void HdrHistogram::reset() {
+    counts.clear();
+    total = 0;
+    min_value = UINT64_MAX;
+    max_value = 0;
+    sum = 0;
+}
+
+uint64_t HdrHistogram::value_at_percentile(double percentile) const {
+    if (total == 0) {
+        return 0;
+    }
+    double clamped = std::min(100.0, std::max(0.0, percentile));
+    uint64_t rank = static_cast<uint64_t>(clamped / 100.0 * static_cast<double>(total) + 0.5);
+    rank = std::max<uint64_t>(1, std::min(rank, total));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return std::min(highest_value(i), max_value);
+        }
+    }
+    return max_value;
+}
+
+StripedHistogram::StripedHistogram() {
+    reset();
+}
+
+size_t StripedHistogram::stripe_index() {
+    thread_local size_t index = std::hash<std::thread::id>()(std::this_thread::get_id()) % stripes;
+    return index;
+}
+
+void StripedHistogram::record(uint64_t value) {
+    Stripe& stripe = data[stripe_index()];
+    stripe.counts[HdrHistogram::index_of(value)].fetch_add(1, std::memory_order_relaxed);
+    uint64_t seen = stripe.max_value.load(std::memory_order_relaxed);
+    while (value > seen && !stripe.max_value.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+    seen = stripe.min_value.load(std::memory_order_relaxed);
+    while (value < seen && !stripe.min_value.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+HdrHistogram StripedHistogram::snapshot() const {
+    HdrHistogram merged;
+    uint64_t min_value = UINT64_MAX;
+    uint64_t max_value = 0;
+    for (const Stripe& stripe : data) {
+        for (size_t i = 0; i < HdrHistogram::bucket_count; ++i) {
+            merged.record_bucket(i, stripe.counts[i].load(std::memory_order_relaxed));
+        }
+        min_value = std::min(min_value, stripe.min_value.load(std::memory_order_relaxed));
+        max_value = std::max(max_value, stripe.max_value.load(std::memory_order_relaxed));
+    }
+    // Extremes are tracked exactly, so the tails are not rounded to bucket bounds
+    if (merged.total > 0) {
+        merged.min_value = min_value;
+        merged.max_value = max_value;
+    }
+    return merged;
+}
+
+void StripedHistogram::reset() {
+    for (Stripe& stripe : data) {
+        for (auto& count : stripe.counts) {
+            count.store(0, std::memory_order_relaxed);
+        }
+        stripe.min_value.store(UINT64_MAX, std::memory_order_relaxed);
+        stripe.max_value.store(0, std::memory_order_relaxed);
+    }
+}
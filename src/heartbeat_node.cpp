@@ -1,41 +1,134 @@
 #include "heartbeat_node.hpp"
-#include <sstream>
+#include <algorithm>
+#include <limits>
 
-HeartbeatNode::HeartbeatNode(const std::string& node_id, bool is_master_node)
-    : Node(node_id), is_master(is_master_node) {
+HeartbeatNode::HeartbeatNode(const std::string& node_id, bool is_master_node,
+                             std::shared_ptr<TaskScheduler> task_scheduler)
+    : Node(node_id, std::move(task_scheduler)), is_master(is_master_node),
+      phi_detector(100, heartbeat_interval_ms, 100.0, heartbeat_interval_ms) {
+    members.set_flip_handler([this](NodeId subject, bool failed) { report_view_change(subject, failed); });
     
     // Initialize metrics
     metrics = {0, 0, 0, 0, get_current_time()};
     
     // Initialize self state
-    node_states[node_id] = {true, get_current_time()};
-}
-
-void HeartbeatNode::start() {
-    is_running = true;
-    node_thread = std::thread(&HeartbeatNode::run, this);
+    members.add(numeric_id, get_current_time_ms());
+    last_heartbeat = get_current_time();
 }
 
 void HeartbeatNode::send_message(const std::string& to_id, const std::string& content) {
-    // In a real implementation, this would send over the network
-    // For simulation, we'll just increment the message counter
     metrics.heartbeats_sent++;
+    transmit(NodeRegistry::instance().intern(to_id), content);
 }
 
 void HeartbeatNode::process_message(const Message& msg) {
     metrics.heartbeats_received++;
     
     if (is_master) {
-        // Master node receives heartbeats from workers
+        // Master node receives heartbeats from workers; a worker that reports
+        // elsewhere now (or probes us while we are excluded) releases us instead
+        if (msg.content == "HEARTBEAT_RELEASE") {
+            forget_worker(msg.from_id);
+            transmit(msg.from_id, "HEARTBEAT_RELEASE_ACK");
+            return;
+        }
         update_node_state(msg.from_id, true);
-    } else {
-        // Worker nodes receive heartbeat responses from master
-        // In this simple implementation, we don't need to do anything with the response
+        if (monitor_ring && msg.content == "HEARTBEAT") {
+            transmit(msg.from_id, "HEARTBEAT_ACK");
+        }
+    } else if (monitor_ring) {
+        // Worker nodes receive heartbeat responses from their owners; an ack from
+        // an excluded monitor means it is reachable again
+        std::lock_guard<std::mutex> lock(states_mutex);
+        if (msg.content == "HEARTBEAT_RELEASE_ACK") {
+            released_monitors.erase(std::remove(released_monitors.begin(), released_monitors.end(), msg.from_id),
+                                    released_monitors.end());
+        }
+        readmit_monitor(msg.from_id);
+        for (size_t i = 0; i < owners.size(); ++i) {
+            if (owners[i] == msg.from_id) {
+                owner_last_ack_ms[i] = get_current_time_ms();
+            }
+        }
+    }
+}
+
+void HeartbeatNode::set_monitor_ring(std::shared_ptr<const HashRing> ring, size_t replicas) {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    monitor_ring = std::move(ring);
+    monitor_replicas = std::max<size_t>(replicas, 1);
+    failed_monitors.clear();
+    monitor_retry_ms.clear();
+    assign_owners();
+}
+
+void HeartbeatNode::assign_owners() {
+    std::vector<NodeId> previous;
+    previous.swap(owners);
+    if (monitor_ring && !is_master) {
+        owners = monitor_ring->owners(numeric_id, monitor_replicas, failed_monitors);
+        if (owners.empty() && !failed_monitors.empty()) {
+            // Every monitor timed out (most likely we are the one cut off): keep
+            // reporting to the ring rather than to nobody
+            failed_monitors.clear();
+            monitor_retry_ms.clear();
+            owners = monitor_ring->owners(numeric_id, monitor_replicas);
+        }
+    }
+    // A new owner gets a full timeout before we give up on it too
+    owner_last_ack_ms.assign(owners.size(), get_current_time_ms());
+    
+    // A dropped owner would keep suspecting us forever; one we return to is ours again
+    for (NodeId monitor : previous) {
+        if (std::find(owners.begin(), owners.end(), monitor) == owners.end() &&
+            std::find(released_monitors.begin(), released_monitors.end(), monitor) == released_monitors.end()) {
+            released_monitors.push_back(monitor);
+        }
+    }
+    for (NodeId monitor : owners) {
+        released_monitors.erase(std::remove(released_monitors.begin(), released_monitors.end(), monitor),
+                                released_monitors.end());
+    }
+}
+
+void HeartbeatNode::check_owners() {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    auto now_ms = get_current_time_ms();
+    bool changed = false;
+    for (size_t i = 0; i < owners.size(); ++i) {
+        if (now_ms - owner_last_ack_ms[i] > monitor_timeout_ms) {
+            failed_monitors.push_back(owners[i]);
+            monitor_retry_ms.push_back(now_ms + monitor_timeout_ms);
+            metrics.monitor_failovers++;
+            changed = true;
+        }
+    }
+    if (changed) {
+        assign_owners();  // The ring successor inherits this worker
     }
 }
 
+void HeartbeatNode::readmit_monitor(NodeId monitor) {
+    auto it = std::find(failed_monitors.begin(), failed_monitors.end(), monitor);
+    if (it == failed_monitors.end()) {
+        return;
+    }
+    monitor_retry_ms.erase(monitor_retry_ms.begin() + (it - failed_monitors.begin()));
+    failed_monitors.erase(it);
+    assign_owners();  // Back to its own slot on the ring if it is one of ours
+}
+
+std::vector<NodeId> HeartbeatNode::get_owners() const {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    return owners;
+}
+
+size_t HeartbeatNode::get_monitored_count() const {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    return members.size() - 1;  // Self is always a member
+}
+
 void HeartbeatNode::periodic_task() {
-    static auto last_heartbeat = get_current_time();
     auto now = get_current_time();
     
     if (!is_master) {
@@ -44,6 +137,9 @@ void HeartbeatNode::periodic_task() {
             send_heartbeat();
             last_heartbeat = now;
         }
+        if (monitor_ring) {
+            check_owners();
+        }
     } else {
         // Master node checks worker health
         check_node_health();
@@ -54,59 +150,165 @@ void HeartbeatNode::send_heartbeat() {
     // Worker nodes send heartbeats to master
     if (!is_master) {
         std::string heartbeat_msg = "HEARTBEAT";
-        send_message("master", heartbeat_msg);
+        if (!monitor_ring) {
+            send_message(master_id, heartbeat_msg);
+            return;
+        }
+        
+        std::vector<NodeId> targets;
+        std::vector<NodeId> releases;
+        {
+            std::lock_guard<std::mutex> lock(states_mutex);
+            targets = owners;
+            // Reachable former owners hear a release every heartbeat until they confirm
+            for (NodeId monitor : released_monitors) {
+                if (std::find(failed_monitors.begin(), failed_monitors.end(), monitor) == failed_monitors.end()) {
+                    releases.push_back(monitor);
+                }
+            }
+            // Excluded monitors get a release as a probe once per monitor timeout; its ack re-admits them
+            auto now_ms = get_current_time_ms();
+            for (size_t i = 0; i < failed_monitors.size(); ++i) {
+                if (now_ms >= monitor_retry_ms[i]) {
+                    releases.push_back(failed_monitors[i]);
+                    monitor_retry_ms[i] = now_ms + monitor_timeout_ms;
+                }
+            }
+        }
+        for (NodeId owner : targets) {
+            metrics.heartbeats_sent++;
+            transmit(owner, heartbeat_msg);
+        }
+        for (NodeId monitor : releases) {
+            metrics.heartbeats_sent++;
+            transmit(monitor, "HEARTBEAT_RELEASE");
+        }
     }
 }
 
 void HeartbeatNode::check_node_health() {
-    auto now = get_current_time();
+    auto now_ms = get_current_time_ms();
     std::lock_guard<std::mutex> lock(states_mutex);
     
-    for (auto& [id, state] : node_states) {
-        if (id != this->id) {  // Don't check self
-            auto time_since_last_heartbeat = std::chrono::duration_cast<std::chrono::milliseconds>(
-                now - state.last_heartbeat).count();
-            
-            if (time_since_last_heartbeat > failure_threshold_ms) {
-                if (state.is_alive) {
-                    state.is_alive = false;
-                    metrics.false_positives++;  // This might be a false positive
-                }
-            }
+    // Only nodes whose deadline has passed are touched, so a quiet tick costs O(1)
+    int newly_failed = 0;
+    deadlines.pop_expired(now_ms, [&](NodeId node_id) {
+        if (members.contains(node_id) && members.is_alive(node_id)) {
+            members.set_alive(node_id, false);
+            newly_failed++;
         }
+    });
+    metrics.suspicions += newly_failed;
+}
+
+void HeartbeatNode::refresh_deadline(NodeId node_id) {
+    if (detection_mode == DetectionMode::FixedTimeout) {
+        deadlines.set(node_id, members.get_last_seen(node_id) + failure_threshold_ms);
+        return;
+    }
+    
+    // phi only changes on heartbeats, so the crossing time is fixed until the next one
+    int64_t deadline = phi_detector.suspicion_deadline(node_id, phi_threshold);
+    if (deadline == std::numeric_limits<int64_t>::max()) {
+        deadlines.remove(node_id);
+    } else {
+        deadlines.set(node_id, deadline);
     }
 }
 
-void HeartbeatNode::update_node_state(const std::string& node_id, bool is_alive) {
+void HeartbeatNode::rebuild_deadlines() {
+    deadlines.clear();
+    for (NodeId node_id : members.get_members()) {
+        if (node_id != numeric_id && members.is_alive(node_id)) {
+            refresh_deadline(node_id);
+        }
+    }
+}
+
+void HeartbeatNode::set_timing(int interval_ms, int timeout_ms) {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    heartbeat_interval_ms = std::max(1, interval_ms);
+    failure_threshold_ms = std::max(1, timeout_ms);
+    monitor_timeout_ms = 2 * failure_threshold_ms;
+    phi_detector = PhiAccrualDetector(100, heartbeat_interval_ms, 100.0, heartbeat_interval_ms);
+    rebuild_deadlines();
+}
+
+void HeartbeatNode::set_detection_mode(DetectionMode mode) {
     std::lock_guard<std::mutex> lock(states_mutex);
-    auto it = node_states.find(node_id);
-    if (it != node_states.end()) {
-        it->second.is_alive = is_alive;
-        it->second.last_heartbeat = get_current_time();
+    detection_mode = mode;
+    rebuild_deadlines();
+}
+
+void HeartbeatNode::set_phi_threshold(double threshold) {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    phi_threshold = threshold;
+    rebuild_deadlines();
+}
+
+void HeartbeatNode::update_node_state(NodeId node_id, bool is_alive) {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    auto now_ms = get_current_time_ms();
+    // The master learns its workers from their first heartbeat
+    members.add(node_id, now_ms);
+    members.mark_seen(node_id, now_ms);
+    members.set_alive(node_id, is_alive);
+    phi_detector.heartbeat(node_id, now_ms);
+    if (is_alive) {
+        refresh_deadline(node_id);
+    } else {
+        deadlines.remove(node_id);
+    }
+}
+
+void HeartbeatNode::forget_worker(NodeId node_id) {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    if (node_id != numeric_id) {
+        members.remove(node_id);  // Clears a standing suspicion through the flip handler
+        phi_detector.remove(node_id);
+        deadlines.remove(node_id);
     }
 }
 
+double HeartbeatNode::get_phi(NodeId node_id) const {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    return phi_detector.phi(node_id, get_current_time_ms());
+}
+
 std::vector<std::string> HeartbeatNode::get_failed_nodes() const {
     std::vector<std::string> failed;
-    std::lock_guard<std::mutex> lock(states_mutex);
-    
-    for (const auto& [id, state] : node_states) {
-        if (!state.is_alive) {
-            failed.push_back(id);
-        }
+    auto& registry = NodeRegistry::instance();
+    for (NodeId node_id : get_failed_node_ids()) {
+        failed.push_back(registry.name(node_id));
     }
-    
     return failed;
 }
 
+std::vector<NodeId> HeartbeatNode::get_failed_node_ids() const {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    return members.collect_failed();
+}
+
+bool HeartbeatNode::is_node_failed(NodeId node_id) const {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    return members.contains(node_id) && !members.is_alive(node_id);
+}
+
 void HeartbeatNode::add_node(const std::string& node_id) {
     std::lock_guard<std::mutex> lock(states_mutex);
-    node_states[node_id] = {true, get_current_time()};
+    NodeId numeric = NodeRegistry::instance().intern(node_id);
+    members.add(numeric, get_current_time_ms());
+    if (numeric != numeric_id && members.is_alive(numeric)) {
+        refresh_deadline(numeric);
+    }
 }
 
 void HeartbeatNode::remove_node(const std::string& node_id) {
     std::lock_guard<std::mutex> lock(states_mutex);
-    node_states.erase(node_id);
+    NodeId numeric = NodeRegistry::instance().find(node_id);
+    members.remove(numeric);
+    phi_detector.remove(numeric);
+    deadlines.remove(numeric);
 }
 
 HeartbeatNode::Metrics HeartbeatNode::get_metrics() const {
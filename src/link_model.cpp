@@ -0,0 +1,239 @@
+#include "link_model.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+LinkModel::LinkModel() {
+    clear();
+}
+
+void LinkModel::clear() {
+    defaults = LinkParams();
+    group_names.assign(1, "default");
+    group_of.clear();
+    links.assign(1, defaults);
+    busy_until_ms.assign(1, 0.0);
+    pair_links.assign(max_groups * max_groups, 0);
+    node_links.clear();
+    cut_groups.fill(0);
+    sides.clear();
+    split = false;
+}
+
+uint32_t LinkModel::add_link(const LinkParams& params) {
+    links.push_back(params);
+    busy_until_ms.push_back(0.0);
+    return static_cast<uint32_t>(links.size() - 1);
+}
+
+void LinkModel::set_defaults(const LinkParams& params) {
+    defaults = params;
+    links[0] = params;
+}
+
+int LinkModel::find_group(const std::string& name) const {
+    auto it = std::find(group_names.begin(), group_names.end(), name);
+    return it == group_names.end() ? -1 : static_cast<int>(it - group_names.begin());
+}
+
+int LinkModel::add_group(const std::string& name) {
+    int existing = find_group(name);
+    if (existing >= 0) {
+        return existing;
+    }
+    if (group_names.size() >= max_groups) {
+        return -1;
+    }
+    group_names.push_back(name);
+    return static_cast<int>(group_names.size() - 1);
+}
+
+void LinkModel::assign(NodeId node, int group) {
+    if (node >= group_of.size()) {
+        group_of.resize(static_cast<size_t>(node) + 1, 0);
+    }
+    group_of[node] = static_cast<uint8_t>(group);
+}
+
+void LinkModel::set_group_link(int from_group, int to_group, const LinkParams& params) {
+    pair_links[static_cast<size_t>(from_group) * max_groups + static_cast<size_t>(to_group)] = add_link(params);
+}
+
+void LinkModel::set_node_link(NodeId from, NodeId to, const LinkParams& params) {
+    node_links[(uint64_t{from} << 32) | to] = add_link(params);
+}
+
+void LinkModel::cut(int from_group, int to_group, bool one_way) {
+    cut_groups[static_cast<size_t>(from_group)] |= uint64_t{1} << to_group;
+    if (!one_way) {
+        cut_groups[static_cast<size_t>(to_group)] |= uint64_t{1} << from_group;
+    }
+}
+
+void LinkModel::heal_groups() {
+    cut_groups.fill(0);
+}
+
+void LinkModel::split_sides(const std::vector<NodeId>& side_a, const std::vector<NodeId>& side_b) {
+    sides.assign(sides.size(), 0xff);
+    for (const auto* side : {&side_a, &side_b}) {
+        uint8_t mask = side == &side_a ? 1 : 2;
+        for (NodeId node : *side) {
+            if (node >= sides.size()) {
+                sides.resize(static_cast<size_t>(node) + 1, 0xff);
+            }
+            sides[node] = mask;
+        }
+    }
+    split = true;
+}
+
+void LinkModel::heal_sides() {
+    sides.clear();
+    split = false;
+}
+
+double LinkModel::reserve(size_t index, size_t bytes, double now_ms) const {
+    double bandwidth = links[index].bandwidth_bytes_per_s;
+    if (bandwidth <= 0.0) {
+        return 0.0;
+    }
+    double& busy_until = busy_until_ms[index];
+    busy_until = std::max(busy_until, now_ms) + static_cast<double>(bytes) * 1000.0 / bandwidth;
+    return busy_until - now_ms;
+}
+
+static bool parse_number(const std::vector<std::string>& words, size_t& pos, double& value) {
+    if (pos >= words.size()) {
+        return false;
+    }
+    char* end = nullptr;
+    value = std::strtod(words[pos].c_str(), &end);
+    if (end == words[pos].c_str() || *end != '\0') {
+        return false;
+    }
+    ++pos;
+    return true;
+}
+
+bool LinkModel::parse_options(std::istream& in, LinkParams& params, bool& one_way, std::string& error) {
+    std::vector<std::string> words;
+    for (std::string word; in >> word;) {
+        words.push_back(word);
+    }
+    for (size_t pos = 0; pos < words.size();) {
+        const std::string& option = words[pos++];
+        if (option == "delay") {
+            if (!parse_number(words, pos, params.mean_delay_ms) || params.mean_delay_ms < 0) {
+                error = "delay needs a mean in ms";
+                return false;
+            }
+            double std_dev;
+            if (parse_number(words, pos, std_dev)) {  // The standard deviation is optional
+                params.std_dev_delay_ms = std::max(0.0, std_dev);
+            }
+        } else if (option == "loss") {
+            if (!parse_number(words, pos, params.loss_rate) || params.loss_rate < 0 || params.loss_rate > 1) {
+                error = "loss needs a rate in [0, 1]";
+                return false;
+            }
+        } else if (option == "bandwidth") {
+            if (!parse_number(words, pos, params.bandwidth_bytes_per_s) || params.bandwidth_bytes_per_s < 0) {
+                error = "bandwidth needs bytes per second";
+                return false;
+            }
+        } else if (option == "oneway") {
+            one_way = true;
+        } else {
+            error = "unknown option '" + option + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LinkModel::parse(std::istream& in, std::string& error) {
+    auto& registry = NodeRegistry::instance();
+    std::string line;
+    int line_number = 0;
+    while (std::getline(in, line)) {
+        ++line_number;
+        line = line.substr(0, line.find('#'));
+        std::istringstream words(line);
+        std::string keyword;
+        if (!(words >> keyword)) {
+            continue;
+        }
+        
+        std::string detail;
+        auto fail = [&](const std::string& message) {
+            error = "line " + std::to_string(line_number) + ": " + message;
+            return false;
+        };
+        if (keyword == "default") {
+            LinkParams params = defaults;
+            bool one_way = false;
+            if (!parse_options(words, params, one_way, detail)) {
+                return fail(detail);
+            }
+            set_defaults(params);
+        } else if (keyword == "group") {
+            std::string name, node;
+            if (!(words >> name)) {
+                return fail("group needs a name");
+            }
+            int group = add_group(name);
+            if (group < 0) {
+                return fail("more than " + std::to_string(max_groups - 1) + " groups");
+            }
+            while (words >> node) {
+                assign(registry.intern(node), group);
+            }
+        } else if (keyword == "link" || keyword == "node-link" || keyword == "partition") {
+            std::string from, to;
+            if (!(words >> from >> to)) {
+                return fail(keyword + " needs two endpoints");
+            }
+            LinkParams params = defaults;
+            bool one_way = false;
+            if (!parse_options(words, params, one_way, detail)) {
+                return fail(detail);
+            }
+            if (keyword == "node-link") {
+                NodeId from_id = registry.intern(from);
+                NodeId to_id = registry.intern(to);
+                set_node_link(from_id, to_id, params);
+                if (!one_way) {
+                    set_node_link(to_id, from_id, params);
+                }
+                continue;
+            }
+            int from_group = find_group(from);
+            int to_group = find_group(to);
+            if (from_group < 0 || to_group < 0) {
+                return fail("unknown group '" + (from_group < 0 ? from : to) + "'");
+            }
+            if (keyword == "partition") {
+                cut(from_group, to_group, one_way);
+                continue;
+            }
+            set_group_link(from_group, to_group, params);
+            if (!one_way) {
+                set_group_link(to_group, from_group, params);
+            }
+        } else {
+            return fail("unknown keyword '" + keyword + "'");
+        }
+    }
+    return true;
+}
+
+bool LinkModel::load(const std::string& file_path, std::string& error) {
+    std::ifstream in(file_path);
+    if (!in) {
+        error = "cannot open " + file_path;
+        return false;
+    }
+    return parse(in, error);
+}
@@ -1,14 +1,326 @@
 #include "simulator.hpp"
+#include "batch_runner.hpp"
+#include "parameter_tuner.hpp"
+#include "sharded_simulator.hpp"
+#include "trace_replay.hpp"
+#include "gossip_node.hpp"
+#include <algorithm>
 #include <iostream>
 #include <cstdlib>
-#include <ctime>
+#include <cstring>
+#include <thread>
+#ifdef __linux__
+#include "udp_transport.hpp"
 
-int main() {
-    // Initialize random seed
-    std::srand(std::time(nullptr));
+// Gossip cluster on real loopback sockets: crash one node and report what the
+// others concluded along with the transport's syscall batching
+static int run_udp_cluster(int num_nodes) {
+    UdpTransport transport;
+    if (!transport.is_open()) {
+        std::cerr << "Could not open UDP transport\n";
+        return 1;
+    }
+    std::vector<std::string> node_ids;
+    for (int i = 0; i < num_nodes; ++i) {
+        node_ids.push_back("udp" + std::to_string(i));
+    }
+    std::vector<std::shared_ptr<GossipNode>> nodes;
+    for (const auto& id : node_ids) {
+        std::vector<std::string> peers;
+        for (const auto& peer : node_ids) {
+            if (peer != id) {
+                peers.push_back(peer);
+            }
+        }
+        nodes.push_back(std::make_shared<GossipNode>(id, peers));
+        if (!transport.add_node(nodes.back())) {
+            std::cerr << "Could not bind a socket for " << id << "\n";
+            return 1;
+        }
+    }
+    transport.start();
+    for (auto& node : nodes) {
+        node->start();
+    }
+    
+    std::this_thread::sleep_for(std::chrono::seconds(3));
+    nodes.back()->set_alive(false);
+    std::this_thread::sleep_for(std::chrono::seconds(6));
+    
+    NodeId crashed = nodes.back()->get_numeric_id();
+    int detected = 0;
+    int false_positives = 0;
+    for (size_t i = 0; i + 1 < nodes.size(); ++i) {
+        detected += nodes[i]->is_node_failed(crashed) ? 1 : 0;
+        false_positives += static_cast<int>(nodes[i]->get_failed_node_ids().size()) -
+                           (nodes[i]->is_node_failed(crashed) ? 1 : 0);
+    }
+    for (auto& node : nodes) {
+        node->stop();
+    }
+    transport.stop();
+    
+    auto stats = transport.get_stats();
+    std::cout << "UDP gossip cluster (" << num_nodes << " nodes)\n"
+              << "Crashed node detected by: " << detected << "/" << (num_nodes - 1) << "\n"
+              << "False Positives: " << false_positives << "\n"
+              << "Datagrams Sent/Received: " << stats.datagrams_sent << "/" << stats.datagrams_received << "\n"
+              << "Bytes Sent: " << stats.bytes_sent << "\n"
+              << "sendmmsg Calls: " << stats.send_calls << " ("
+              << (stats.send_calls ? static_cast<double>(stats.datagrams_sent) / stats.send_calls : 0.0)
+              << " datagrams/call)\n"
+              << "recvmmsg Calls: " << stats.receive_calls << " ("
+              << (stats.receive_calls ? static_cast<double>(stats.datagrams_received) / stats.receive_calls : 0.0)
+              << " datagrams/call)\n"
+              << "Dropped: " << stats.dropped << "\n";
+    return 0;
+}
+#endif
+
+// Summarizes a recorded trace and points at where false positives took off
+static int run_replay(const std::string& path) {
+    TraceReplay replay;
+    if (!replay.open(path)) {
+        std::cerr << "Could not read trace " << path << "\n";
+        return 1;
+    }
+    auto wall_start = std::chrono::steady_clock::now();
+    auto summary = replay.summarize();
+    auto buckets = replay.timeline(1000);
+    int64_t onset = summary.peak_false_positives > 0
+        ? replay.find_false_positive_onset((summary.peak_false_positives + 1) / 2) : -1;
+    double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall_start).count();
+    
+    std::cout << "Trace " << path << " (seed " << replay.get_seed() << ", " << replay.size() << " records)\n"
+              << "Sends: " << summary.sends << ", Drops: " << summary.drops
+              << ", Deliveries: " << summary.deliveries << "\n"
+              << "Suspicions: " << summary.suspicions << " (" << summary.false_suspicions << " false), Clears: "
+              << summary.clears << "\n"
+              << "Crashes: " << summary.crashes << ", Recoveries: " << summary.recoveries << "\n"
+              << "Peak False Positives: " << summary.peak_false_positives << " at " << summary.peak_time_ms << "ms\n"
+              << "Half-Peak Onset: " << onset << "ms\n"
+              << "Replayed in " << wall_ms << "ms\n\n";
+    for (const auto& bucket : buckets) {
+        if (bucket.false_suspicions > 0) {
+            std::cout << bucket.start_ms << "ms: " << bucket.messages << " messages, "
+                      << bucket.false_suspicions << " new false suspicions, "
+                      << bucket.false_positives << " wrongly suspected pairs\n";
+        }
+    }
+    return 0;
+}
+
+static void print_result(const std::string& label, const Simulator::TestResult& result) {
+    std::cout << label << ":\n"
+              << "Detection Time (first/median/last): " << Simulator::format_ms(result.detection_time_ms) << "/"
+              << Simulator::format_ms(result.median_detection_ms) << "/"
+              << Simulator::format_ms(result.last_detection_ms) << "\n"
+              << "False Positives: " << result.false_positives
+              << " (" << result.mistake_rate << "/pair/s, lasting " << result.mean_mistake_ms
+              << "ms, recurring every " << result.mean_recurrence_ms << "ms)\n"
+              << "False Negatives: " << result.false_negatives << "\n"
+              << "Accuracy: " << (result.accuracy * 100) << "%\n"
+              << "Messages Sent: " << result.messages_sent << "\n"
+              << "Bytes Sent: " << result.bytes_sent << " (saved " << result.bytes_saved << ")\n";
+}
+
+int main(int argc, char** argv) {
+    // --virtual-time runs every scenario on the discrete-event clock,
+    // --worker-pool multiplexes nodes over a shared pool of threads
+    // --delta-gossip sends only membership entries changed since the last message to each peer
+    //   (heartbeats move every entry every round, so the saving is small; each test prints it),
+    // --anti-entropy exchanges Merkle digests and only the id ranges that differ,
+    // --coalesce sends each node's tick as one batch, sharing envelopes between messages to a peer,
+    // --peer-sampling random|round-robin|zone picks gossip targets (--zones N racks for zone, default 4),
+    // --compare-sampling only prints gossip convergence under each peer sampling strategy,
+    // --timing-wheel delivers through sharded timing wheels instead of one heap,
+    // --phi-sweep only prints the heartbeat latency/accuracy curve across phi thresholds,
+    // --monitors N shards heartbeat monitoring over N masters,
+    // --batch N runs every scenario and size with N seeds in parallel and prints summaries,
+    // --udp N runs an N-node gossip cluster over real loopback UDP sockets (Linux),
+    // --shards S splits a gossip cluster (--shard-nodes N, default 500) across S processes,
+    // --seed N fixes the run seed (otherwise drawn and printed so the run can be repeated),
+    // --trace FILE records the run to a binary trace, --replay FILE analyzes one,
+    // --topology FILE loads per-group/per-link delay, loss, bandwidth and partitions (see link_model.hpp),
+    // --latency prints delay percentiles per message type and the slowest links for each size,
+    // --scenario FILE runs a scripted scenario (see scenario_script.hpp) instead of the built-in ones,
+    // --tune FILE searches the scenario's tune axes for the fastest detection within its budgets
+    auto mode = Simulator::ExecutionMode::ThreadPerNode;
+    bool delta_gossip = false;
+    bool anti_entropy = false;
+    bool coalescing = false;
+    auto peer_sampling = PeerSampler::Strategy::Random;
+    int zones = 4;
+    bool compare_sampling = false;
+    auto delivery_queue = Network::DeliveryQueue::Heap;
+    bool phi_sweep = false;
+    int monitors = 1;
+    int batch_seeds = 0;
+    int udp_nodes = 0;
+    int shards = 0;
+    int shard_nodes = 500;
+    bool seeded = false;
+    uint64_t seed = 0;
+    std::string trace_path;
+    std::string replay_path;
+    std::string topology_path;
+    bool latency_report = false;
+    std::string scenario_path;
+    std::string tune_path;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--virtual-time") == 0) {
+            mode = Simulator::ExecutionMode::VirtualTime;
+        } else if (std::strcmp(argv[i], "--worker-pool") == 0) {
+            mode = Simulator::ExecutionMode::SharedPool;
+        } else if (std::strcmp(argv[i], "--delta-gossip") == 0) {
+            delta_gossip = true;
+        } else if (std::strcmp(argv[i], "--anti-entropy") == 0) {
+            anti_entropy = true;
+        } else if (std::strcmp(argv[i], "--coalesce") == 0) {
+            coalescing = true;
+        } else if (std::strcmp(argv[i], "--peer-sampling") == 0 && i + 1 < argc) {
+            ++i;
+            if (std::strcmp(argv[i], "round-robin") == 0) {
+                peer_sampling = PeerSampler::Strategy::RoundRobin;
+            } else if (std::strcmp(argv[i], "zone") == 0) {
+                peer_sampling = PeerSampler::Strategy::ZoneAware;
+            } else {
+                peer_sampling = PeerSampler::Strategy::Random;
+            }
+        } else if (std::strcmp(argv[i], "--zones") == 0 && i + 1 < argc) {
+            zones = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--compare-sampling") == 0) {
+            compare_sampling = true;
+        } else if (std::strcmp(argv[i], "--timing-wheel") == 0) {
+            delivery_queue = Network::DeliveryQueue::TimingWheel;
+        } else if (std::strcmp(argv[i], "--phi-sweep") == 0) {
+            phi_sweep = true;
+        } else if (std::strcmp(argv[i], "--monitors") == 0 && i + 1 < argc) {
+            monitors = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch_seeds = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--udp") == 0 && i + 1 < argc) {
+            udp_nodes = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--shards") == 0 && i + 1 < argc) {
+            shards = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--shard-nodes") == 0 && i + 1 < argc) {
+            shard_nodes = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+            seeded = true;
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--topology") == 0 && i + 1 < argc) {
+            topology_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--latency") == 0) {
+            latency_report = true;
+        } else if (std::strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) {
+            scenario_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--tune") == 0 && i + 1 < argc) {
+            tune_path = argv[++i];
+        }
+    }
+    
+    if (!replay_path.empty()) {
+        return run_replay(replay_path);
+    }
+    
+    if (udp_nodes > 0) {
+#ifdef __linux__
+        return run_udp_cluster(udp_nodes);
+#else
+        std::cerr << "--udp needs Linux (sendmmsg/recvmmsg/epoll)\n";
+        return 1;
+#endif
+    }
+    
+    if (shards > 0) {
+        ShardedSimulator::Config config;
+        config.num_nodes = shard_nodes;
+        config.num_shards = shards;
+        config.num_failures = std::max(1, shard_nodes / 100);
+        if (seeded) {
+            config.seed = seed;
+        }
+        auto result = ShardedSimulator(config).run();
+        ShardedSimulator::print(config, result);
+        return result.ok ? 0 : 1;
+    }
+    
+    if (!tune_path.empty()) {
+        ScenarioScript script;
+        std::string error;
+        if (!script.load(tune_path, error)) {
+            std::cerr << "Could not load scenario: " << error << "\n";
+            return 1;
+        }
+        auto report = ParameterTuner().tune(script, seeded ? seed : 1);
+        ParameterTuner::print(report);
+        return report.found ? 0 : 1;
+    }
+    
+    if (batch_seeds > 0) {
+        BatchRunner runner;
+        auto aggregates = runner.run({BatchRunner::Scenario::SingleNodeFailure, BatchRunner::Scenario::MultipleFailures,
+                                      BatchRunner::Scenario::NetworkPartition, BatchRunner::Scenario::HighLoad,
+                                      BatchRunner::Scenario::Recovery},
+                                     {5, 10, 20, 50}, batch_seeds, seeded ? seed : 1);
+        BatchRunner::print(aggregates);
+        return 0;
+    }
     
     // Create simulator
-    Simulator simulator;
+    Simulator simulator(mode);
+    simulator.set_delta_gossip(delta_gossip);
+    simulator.set_anti_entropy(anti_entropy);
+    simulator.set_coalescing(coalescing);
+    simulator.set_peer_sampling(peer_sampling);
+    simulator.set_zones(zones);
+    simulator.set_delivery_queue(delivery_queue);
+    simulator.set_heartbeat_monitors(monitors);
+    if (seeded) {
+        simulator.set_seed(seed);
+    }
+    simulator.set_link_stats(latency_report);
+    std::string topology_error;
+    if (!topology_path.empty() && !simulator.load_topology(topology_path, topology_error)) {
+        std::cerr << "Could not load topology: " << topology_error << "\n";
+        return 1;
+    }
+    std::cout << "Run seed: " << simulator.get_seed() << "\n";
+    if (!trace_path.empty() && !simulator.start_trace(trace_path)) {
+        std::cerr << "Could not open trace " << trace_path << "\n";
+        return 1;
+    }
+    
+    if (compare_sampling) {
+        for (int size : {20, 50, 200}) {
+            std::cout << "\n=== Peer sampling with " << size << " nodes, " << zones << " zones ===\n";
+            simulator.compare_peer_sampling(size);
+        }
+        return 0;
+    }
+    
+    if (!scenario_path.empty()) {
+        ScenarioScript script;
+        std::string error;
+        if (!script.load(scenario_path, error)) {
+            std::cerr << "Could not load scenario: " << error << "\n";
+            return 1;
+        }
+        print_result(script.name, simulator.run_scenario(script));
+        if (latency_report) {
+            simulator.print_latency_report();
+        }
+        return 0;
+    }
+    
+    if (phi_sweep) {
+        simulator.run_phi_threshold_sweep(50, {1.0, 2.0, 3.0, 5.0, 8.0, 12.0});
+        return 0;
+    }
     
     // Run tests with different network sizes
     std::vector<int> network_sizes = {5, 10, 20, 50};
@@ -22,32 +334,23 @@ int main() {
         auto network_partition = simulator.run_network_partition_test(size);
         auto high_load = simulator.run_high_load_test(size);
         auto recovery = simulator.run_recovery_test(size);
+        if (latency_report) {
+            // Stats are reset per scenario, so this covers the recovery test
+            std::cout << "\nLatency (Recovery Test):\n";
+            simulator.print_latency_report();
+        }
         
         // Print results
-        std::cout << "\nSingle Node Failure Test:\n"
-                  << "Detection Time: " << single_failure.detection_time_ms << "ms\n"
-                  << "Accuracy: " << (single_failure.accuracy * 100) << "%\n"
-                  << "Messages Sent: " << single_failure.messages_sent << "\n\n";
-        
-        std::cout << "Multiple Failures Test:\n"
-                  << "Detection Time: " << multiple_failures.detection_time_ms << "ms\n"
-                  << "Accuracy: " << (multiple_failures.accuracy * 100) << "%\n"
-                  << "Messages Sent: " << multiple_failures.messages_sent << "\n\n";
-        
-        std::cout << "Network Partition Test:\n"
-                  << "Detection Time: " << network_partition.detection_time_ms << "ms\n"
-                  << "Accuracy: " << (network_partition.accuracy * 100) << "%\n"
-                  << "Messages Sent: " << network_partition.messages_sent << "\n\n";
-        
-        std::cout << "High Load Test:\n"
-                  << "Detection Time: " << high_load.detection_time_ms << "ms\n"
-                  << "Accuracy: " << (high_load.accuracy * 100) << "%\n"
-                  << "Messages Sent: " << high_load.messages_sent << "\n\n";
-        
-        std::cout << "Recovery Test:\n"
-                  << "Detection Time: " << recovery.detection_time_ms << "ms\n"
-                  << "Accuracy: " << (recovery.accuracy * 100) << "%\n"
-                  << "Messages Sent: " << recovery.messages_sent << "\n";
+        std::cout << "\n";
+        print_result("Single Node Failure Test", single_failure);
+        std::cout << "\n";
+        print_result("Multiple Failures Test", multiple_failures);
+        std::cout << "\n";
+        print_result("Network Partition Test", network_partition);
+        std::cout << "\n";
+        print_result("High Load Test", high_load);
+        std::cout << "\n";
+        print_result("Recovery Test", recovery);
     }
     
     return 0;
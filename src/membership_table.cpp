@@ -0,0 +1,83 @@
+#include "membership_table.hpp"
+#include <algorithm>
+
+bool MembershipTable::add(NodeId id, int64_t now_ms) {
+    if (id >= present.size()) {
+        size_t new_size = static_cast<size_t>(id) + 1;
+        present.resize(new_size, 0);
+        alive.resize(new_size, 0);
+        last_seen_ms.resize(new_size, 0);
+        suspicion.resize(new_size, 0);
+    }
+
+    bool inserted = !present[id];
+    if (inserted) {
+        alive[id] = 1;  // New members start alive without reporting a flip
+        present[id] = 1;
+        members.push_back(id);
+    }
+    mark_seen(id, now_ms);
+    return inserted;
+}
+
+bool MembershipTable::remove(NodeId id) {
+    if (!contains(id)) {
+        return false;
+    }
+    bool was_failed = !alive[id];
+    present[id] = 0;
+    alive[id] = 0;
+    if (was_failed && on_flip) {
+        on_flip(id, false);  // No longer listed as failed
+    }
+    auto it = std::find(members.begin(), members.end(), id);
+    *it = members.back();
+    members.pop_back();
+    return true;
+}
+
+void MembershipTable::mark_seen(NodeId id, int64_t now_ms) {
+    write_alive(id, 1);
+    last_seen_ms[id] = now_ms;
+    suspicion[id] = 0;
+}
+
+void MembershipTable::advance_suspicion(NodeId self, int64_t now_ms, int64_t stale_after_ms,
+                                        int32_t threshold) {
+    size_t count = present.size();
+    for (size_t id = 0; id < count; ++id) {
+        if (!present[id] || id == self) {
+            continue;
+        }
+        if (now_ms - last_seen_ms[id] > stale_after_ms) {
+            suspicion[id]++;
+            if (suspicion[id] >= threshold) {
+                write_alive(static_cast<NodeId>(id), 0);
+            }
+        }
+    }
+}
+
+int MembershipTable::expire_stale(NodeId self, int64_t now_ms, int64_t timeout_ms) {
+    // Walks the member list rather than the id range, so a monitor owning a
+    // small shard of a large id space only pays for its own shard
+    int newly_failed = 0;
+    for (NodeId id : members) {
+        if (alive[id] && id != self && now_ms - last_seen_ms[id] > timeout_ms) {
+            write_alive(id, 0);
+            newly_failed++;
+        }
+    }
+    return newly_failed;
+}
+
+std::vector<NodeId> MembershipTable::collect_failed(int32_t suspicion_threshold) const {
+    std::vector<NodeId> failed;
+    size_t count = present.size();
+    for (size_t id = 0; id < count; ++id) {
+        if (present[id] && (!alive[id] || suspicion[id] >= suspicion_threshold)) {
+            failed.push_back(static_cast<NodeId>(id));
+        }
+    }
+    return failed;
+}
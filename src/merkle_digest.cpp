@@ -0,0 +1,80 @@
+#include "merkle_digest.hpp"
+
+uint64_t MerkleDigest::entry_hash(NodeId id, bool alive, uint64_t epoch) {
+    // splitmix64 finalizer over the packed fields
+    uint64_t x = (static_cast<uint64_t>(id) << 1 | (alive ? 1 : 0)) ^ (epoch * 0x9e3779b97f4a7c15ULL);
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+void MerkleDigest::clear() {
+    // Keeps the vectors so a digest rebuilt every round stops allocating
+    for (auto& level : levels) {
+        level.clear();
+    }
+}
+
+void MerkleDigest::add(NodeId id, uint64_t hash) {
+    if (levels.empty()) {
+        levels.resize(1);
+    }
+    size_t leaf = index_of(id, 0);
+    if (leaf >= levels[0].size()) {
+        levels[0].resize(leaf + 1, 0);
+    }
+    levels[0][leaf] ^= hash;
+}
+
+void MerkleDigest::build() {
+    if (levels.empty()) {
+        levels.resize(1);
+    }
+    // Fold each level into the next until a single node is left, reusing the vectors
+    size_t level = 0;
+    while (levels[level].size() > 1) {
+        if (levels.size() <= level + 1) {
+            levels.emplace_back();
+        }
+        auto& parent = levels[level + 1];
+        parent.assign((levels[level].size() + fanout - 1) / fanout, 0);
+        for (size_t i = 0; i < levels[level].size(); ++i) {
+            parent[i >> fanout_bits] ^= levels[level][i];
+        }
+        ++level;
+    }
+    levels.resize(level + 1);
+    if (levels[level].empty()) {
+        levels[level].push_back(0);
+    }
+}
+
+void MerkleDigest::toggle(NodeId id, uint64_t hash) {
+    if (levels.empty()) {
+        levels.resize(1);
+    }
+    // A new root above the old one covers the same ids, so it starts with the same hash
+    while (index_of(id, get_depth()) != 0) {
+        uint64_t root = levels.back().empty() ? 0 : levels.back()[0];
+        levels.push_back({root});
+    }
+    for (size_t level = 0; level < levels.size(); ++level) {
+        size_t index = index_of(id, static_cast<int>(level));
+        auto& nodes = levels[level];
+        if (index >= nodes.size()) {
+            nodes.resize(index + 1, 0);
+        }
+        nodes[index] ^= hash;
+    }
+}
+
+uint64_t MerkleDigest::get(int level, size_t index) const {
+    if (levels.empty()) {
+        return 0;
+    }
+    if (level > get_depth()) {
+        return index == 0 ? levels.back()[0] : 0;
+    }
+    const auto& nodes = levels[static_cast<size_t>(level)];
+    return index < nodes.size() ? nodes[index] : 0;
+}
@@ -1,109 +1,654 @@
 #include "network.hpp"
 #include "node.hpp"
+#include "gossip_codec.hpp"
+#include "swim_codec.hpp"
 #include <algorithm>
 #include <cmath>
 #include <chrono>
 
-Network::Network()
-    : rng(std::random_device{}()),
-      loss_dist(0.0, 1.0),
-      delay_dist(mean_delay, std_dev_delay) {
+namespace {
+uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+double unit(uint64_t bits) {
+    return static_cast<double>(bits >> 11) * (1.0 / 9007199254740992.0);  // [0, 1)
+}
+}
+
+Network::Network(std::shared_ptr<TaskScheduler> task_scheduler, DeliveryQueue queue_kind)
+    : scheduler(std::move(task_scheduler)),
+      seed(std::random_device{}()),
+      trace(nullptr),
+      delivery_queue(DeliveryQueue::Heap),
+      link_stats_enabled(false) {
+    for (auto& slot : wakeups) {
+        slot.store(-1, std::memory_order_relaxed);
+    }
+    topology_snapshots.push_back(std::make_unique<LinkModel>());
+    topology.store(topology_snapshots.back().get());
     reset_stats();
+    set_delivery_queue(queue_kind);
+}
+
+Network::~Network() {
+    discard_in_flight();
+}
+
+void Network::discard_in_flight() {
+    // Return undelivered envelopes, and any coalesced behind them, to the pool
+    auto& pool = EnvelopePool::instance();
+    auto release = [&pool](Envelope* envelope) {
+        while (envelope) {
+            Envelope* bundled = envelope->bundled;
+            pool.release(envelope);
+            envelope = bundled;
+        }
+    };
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        while (!message_queue.empty()) {
+            release(message_queue.top());
+            message_queue.pop();
+        }
+    }
+    for (auto& shard : wheel_shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->wheel.drain([&](Envelope*&& envelope) { release(envelope); });
+    }
+}
+
+void Network::set_delivery_queue(DeliveryQueue queue_kind) {
+    // Pull everything still in flight out of the current structure
+    std::vector<Envelope*> in_flight;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        while (!message_queue.empty()) {
+            in_flight.push_back(message_queue.top());
+            message_queue.pop();
+        }
+    }
+    for (auto& shard : wheel_shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->wheel.drain([&](Envelope*&& envelope) { in_flight.push_back(envelope); });
+    }
+
+    if (queue_kind == DeliveryQueue::TimingWheel && wheel_shards.empty()) {
+        int64_t start_tick = to_tick(get_current_time());
+        for (size_t i = 0; i < num_wheel_shards; ++i) {
+            wheel_shards.push_back(std::make_unique<WheelShard>(start_tick));
+        }
+    }
+
+    delivery_queue = queue_kind;
+    for (Envelope* envelope : in_flight) {
+        enqueue(envelope);
+    }
+}
+
+int64_t Network::to_tick(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+void Network::enqueue(Envelope* envelope) {
+    if (delivery_queue == DeliveryQueue::TimingWheel) {
+        auto& shard = *wheel_shards[envelope->to_id % num_wheel_shards];
+        int64_t due_tick = to_tick(envelope->delivery_time);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.wheel.insert(due_tick, envelope);
+    } else {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        message_queue.push(envelope);
+    }
+}
+
+void Network::enqueue_all(Envelope* const* envelopes, size_t count) {
+    if (delivery_queue == DeliveryQueue::TimingWheel) {
+        for (size_t i = 0; i < count; ++i) {
+            enqueue(envelopes[i]);  // Shards are per destination, so there is little to share
+        }
+        return;
+    }
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    for (size_t i = 0; i < count; ++i) {
+        message_queue.push(envelopes[i]);
+    }
+}
+
+void Network::collect_due(std::chrono::system_clock::time_point now, std::vector<Envelope*>& out) {
+    if (delivery_queue == DeliveryQueue::TimingWheel) {
+        int64_t now_tick = to_tick(now);
+        for (auto& shard : wheel_shards) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->wheel.advance(now_tick, [&](Envelope*&& envelope) { out.push_back(envelope); });
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    while (!message_queue.empty() && message_queue.top()->delivery_time <= now) {
+        out.push_back(message_queue.top());
+        message_queue.pop();
+    }
 }
 
 void Network::add_node(const std::string& node_id, std::shared_ptr<Node> node) {
+    NodeId id = NodeRegistry::instance().intern(node_id);
     std::lock_guard<std::mutex> lock(nodes_mutex);
-    nodes[node_id] = node;
+    if (id >= nodes.size()) {
+        nodes.resize(static_cast<size_t>(id) + 1);
+    }
+    node->attach_transport(this);
+    node->attach_trace(trace);
+    nodes[id] = node;
 }
 
 void Network::remove_node(const std::string& node_id) {
+    NodeId id = NodeRegistry::instance().find(node_id);
     std::lock_guard<std::mutex> lock(nodes_mutex);
-    nodes.erase(node_id);
+    if (id < nodes.size() && nodes[id]) {
+        TraceRecorder* recorder = trace;
+        if (recorder) {
+            recorder->record(TraceEvent::Leave, to_tick(get_current_time()), id);
+        }
+        nodes[id]->attach_transport(nullptr);
+        nodes[id]->attach_trace(nullptr);
+        nodes[id].reset();
+    }
 }
 
 std::shared_ptr<Node> Network::get_node(const std::string& node_id) {
+    return get_node(NodeRegistry::instance().find(node_id));
+}
+
+std::shared_ptr<Node> Network::get_node(NodeId node_id) {
     std::lock_guard<std::mutex> lock(nodes_mutex);
-    auto it = nodes.find(node_id);
-    return (it != nodes.end()) ? it->second : nullptr;
+    return (node_id < nodes.size()) ? nodes[node_id] : nullptr;
 }
 
 void Network::send_message(const std::string& from_id, const std::string& to_id, const std::string& content) {
-    if (should_drop_message()) {
-        update_stats(0, true);
-        return;
+    auto& registry = NodeRegistry::instance();
+    send_message(registry.intern(from_id), registry.intern(to_id), content);
+}
+
+void Network::count_sent(size_t bytes, size_t full_state_bytes) {
+    stats.sent_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    if (full_state_bytes > bytes) {
+        stats.saved_bytes.fetch_add(full_state_bytes - bytes, std::memory_order_relaxed);
     }
+}
 
-    int delay = calculate_delay();
-    auto delivery_time = std::chrono::system_clock::now() + std::chrono::milliseconds(delay);
+void Network::count_drop(NodeId from_id, NodeId to_id, size_t bytes, Route verdict,
+                         std::chrono::system_clock::time_point send_time) {
+    if (verdict == Route::Blocked) {
+        stats.blocked_messages.fetch_add(1, std::memory_order_relaxed);
+    }
+    update_stats(0, true);
+    if (link_stats_enabled.load(std::memory_order_relaxed)) {
+        record_link(from_id, to_id, bytes, true);
+    }
+    TraceRecorder* recorder = trace;
+    if (recorder) {
+        recorder->record(TraceEvent::Drop, to_tick(send_time), from_id, to_id, static_cast<uint32_t>(bytes));
+    }
+}
 
-    Message msg{from_id, to_id, content, delivery_time};
-    
-    {
-        std::lock_guard<std::mutex> lock(queue_mutex);
-        message_queue.push(msg);
+Envelope* Network::wrap(NodeId from_id, NodeId to_id, const std::string& content,
+                        std::chrono::system_clock::time_point send_time,
+                        std::chrono::system_clock::time_point delivery_time, uint64_t& allocations) {
+    TraceRecorder* recorder = trace;
+    if (recorder) {
+        recorder->record(TraceEvent::Send, to_tick(send_time), from_id, to_id,
+                         static_cast<uint32_t>(content.size()));
+    }
+    Envelope* envelope = EnvelopePool::instance().acquire(allocations);
+    if (envelope->content.capacity() < content.size()) {
+        allocations++;  // Recycled buffers only grow until they fit the largest payload
+    }
+    envelope->from_id = from_id;
+    envelope->to_id = to_id;
+    envelope->content.assign(content);
+    envelope->sent_time = send_time;
+    envelope->delivery_time = delivery_time;
+    envelope->bundled = nullptr;
+    if (link_stats_enabled.load(std::memory_order_relaxed)) {
+        record_link(from_id, to_id, content.size(), false);
+    }
+    return envelope;
+}
+
+void Network::wake_at(std::chrono::system_clock::time_point delivery_time) {
+    if (!scheduler) {
+        return;
+    }
+    // Keyed by the exact time: on a virtual clock a whole burst lands on the same
+    // instant, while wall-clock sends rarely match and keep their own wake-ups
+    int64_t when = delivery_time.time_since_epoch().count();
+    auto& slot = wakeups[static_cast<uint64_t>(to_tick(delivery_time)) % num_wakeup_slots];
+    if (slot.exchange(when) == when) {
+        return;  // That wake-up has not started yet and will see this message
+    }
+    scheduler->schedule_at(delivery_time, [this, when, &slot]() {
+        // Release the slot before collecting, so a send racing with the
+        // collection either is collected here or schedules its own wake-up
+        int64_t expected = when;
+        slot.compare_exchange_strong(expected, -1);
+        process_messages();
+    });
+}
+
+void Network::send_message(NodeId from_id, NodeId to_id, const std::string& content,
+                           size_t full_state_bytes) {
+    count_sent(content.size(), full_state_bytes);
+    auto send_time = get_current_time();
+    int delay = 0;
+    Route verdict = route(from_id, to_id, content.size(),
+                          std::chrono::duration<double, std::milli>(send_time.time_since_epoch()).count(), delay);
+    if (verdict != Route::Deliver) {
+        count_drop(from_id, to_id, content.size(), verdict, send_time);
+        return;
     }
 
+    auto delivery_time = send_time + std::chrono::milliseconds(delay);
+    uint64_t allocations = 0;
+    Envelope* envelope = wrap(from_id, to_id, content, send_time, delivery_time, allocations);
+    if (allocations > 0) {
+        stats.allocations.fetch_add(allocations, std::memory_order_relaxed);
+    }
+    enqueue(envelope);
+    wake_at(delivery_time);
     update_stats(delay, false);
 }
 
-void Network::process_messages() {
-    auto now = std::chrono::system_clock::now();
-    std::vector<Message> messages_to_process;
+void Network::send_batch(NodeId from_id, const OutgoingMessage* messages, size_t count) {
+    // Group by destination, keeping send order within each group
+    thread_local std::vector<uint32_t> order;
+    order.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        order[i] = static_cast<uint32_t>(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [messages](uint32_t a, uint32_t b) {
+        return messages[a].to_id < messages[b].to_id;
+    });
+    
+    struct Group {
+        size_t begin;
+        size_t end;
+        size_t bytes;
+        Route verdict;
+        int delay;
+    };
+    thread_local std::vector<Group> groups;
+    groups.clear();
+    for (size_t begin = 0, end = 0; begin < count; begin = end) {
+        NodeId to_id = messages[order[begin]].to_id;
+        size_t bytes = 0;
+        for (end = begin; end < count && messages[order[end]].to_id == to_id; ++end) {
+            const auto& message = messages[order[end]];
+            count_sent(message.content.size(), message.full_state_bytes);
+            bytes += message.content.size();
+        }
+        groups.push_back(Group{begin, end, bytes, Route::Deliver, 0});
+    }
+    
+    // Each group shares one fate and one delay
+    auto send_time = get_current_time();
+    double now_ms = std::chrono::duration<double, std::milli>(send_time.time_since_epoch()).count();
+    for (auto& group : groups) {
+        group.verdict = route(from_id, messages[order[group.begin]].to_id, group.bytes, now_ms, group.delay);
+    }
+    
+    thread_local std::vector<Envelope*> heads;
+    heads.clear();
+    uint64_t allocations = 0;
+    for (const auto& group : groups) {
+        NodeId to_id = messages[order[group.begin]].to_id;
+        if (group.verdict != Route::Deliver) {
+            for (size_t i = group.begin; i < group.end; ++i) {
+                count_drop(from_id, to_id, messages[order[i]].content.size(), group.verdict, send_time);
+            }
+            continue;
+        }
+        auto delivery_time = send_time + std::chrono::milliseconds(group.delay);
+        Envelope* tail = nullptr;
+        for (size_t i = group.begin; i < group.end; ++i) {
+            Envelope* envelope = wrap(from_id, to_id, messages[order[i]].content, send_time, delivery_time,
+                                      allocations);
+            if (tail) {
+                tail->bundled = envelope;
+            } else {
+                heads.push_back(envelope);
+            }
+            tail = envelope;
+            update_stats(group.delay, false);
+        }
+        if (group.end - group.begin > 1) {
+            stats.coalesced_messages.fetch_add(group.end - group.begin - 1, std::memory_order_relaxed);
+        }
+    }
+    if (allocations > 0) {
+        stats.allocations.fetch_add(allocations, std::memory_order_relaxed);
+    }
+    
+    enqueue_all(heads.data(), heads.size());
+    for (Envelope* head : heads) {
+        wake_at(head->delivery_time);
+    }
+}
 
-    {
-        std::lock_guard<std::mutex> lock(queue_mutex);
-        while (!message_queue.empty() && message_queue.top().delivery_time <= now) {
-            messages_to_process.push_back(message_queue.top());
-            message_queue.pop();
+void Network::process_messages() {
+    auto now = get_current_time();
+    // Reused per thread so a delivery round does not allocate either
+    thread_local std::vector<Envelope*> due;
+    thread_local std::vector<Envelope*> messages_to_process;
+    due.clear();
+    messages_to_process.clear();
+    collect_due(now, due);
+    if (due.empty()) {
+        return;
+    }
+    
+    // Unbundle coalesced sends, then group by destination; the stable sort keeps
+    // each destination's messages in delivery order
+    for (Envelope* envelope : due) {
+        while (envelope) {
+            messages_to_process.push_back(envelope);
+            Envelope* bundled = envelope->bundled;
+            envelope->bundled = nullptr;
+            envelope = bundled;
         }
     }
+    std::stable_sort(messages_to_process.begin(), messages_to_process.end(),
+                     [](const Envelope* a, const Envelope* b) { return a->to_id < b->to_id; });
 
-    for (const auto& msg : messages_to_process) {
-        std::lock_guard<std::mutex> lock(nodes_mutex);
-        auto it = nodes.find(msg.to_id);
-        if (it != nodes.end()) {
-            it->second->receive_message(msg.from_id, msg.content);
+    TraceRecorder* recorder = trace;
+    bool per_link = link_stats_enabled.load(std::memory_order_relaxed);
+    int64_t now_tick = to_tick(now);
+    uint64_t batches = 0;
+    std::lock_guard<std::mutex> lock(nodes_mutex);
+    for (size_t begin = 0, end = 0; begin < messages_to_process.size(); begin = end) {
+        NodeId to_id = messages_to_process[begin]->to_id;
+        end = begin + 1;
+        while (end < messages_to_process.size() && messages_to_process[end]->to_id == to_id) {
+            ++end;
+        }
+        Node* node = to_id < nodes.size() ? nodes[to_id].get() : nullptr;
+        if (!node) {
+            for (size_t i = begin; i < end; ++i) {
+                EnvelopePool::instance().release(messages_to_process[i]);
+            }
+            continue;
         }
+        for (size_t i = begin; i < end; ++i) {
+            const Envelope* envelope = messages_to_process[i];
+            if (recorder) {
+                recorder->record(TraceEvent::Deliver, now_tick, envelope->from_id, to_id,
+                                 static_cast<uint32_t>(envelope->content.size()));
+            }
+            uint64_t delay_us = static_cast<uint64_t>(std::max<int64_t>(0,
+                std::chrono::duration_cast<std::chrono::microseconds>(now - envelope->sent_time).count()));
+            latency[static_cast<size_t>(classify(envelope->content))].delivery_delay_us.record(delay_us);
+            if (per_link) {
+                record_link_delay(envelope->from_id, to_id, delay_us);
+            }
+        }
+        node->receive_batch(messages_to_process.data() + begin, end - begin);
+        batches++;
     }
+    stats.delivery_batches.fetch_add(batches, std::memory_order_relaxed);
 }
 
 void Network::simulate_network_partition(const std::vector<std::string>& partition1,
                                       const std::vector<std::string>& partition2,
                                       int duration_ms) {
-    std::lock_guard<std::mutex> lock(partition_mutex);
-    
-    std::unordered_set<std::string> set1(partition1.begin(), partition1.end());
-    std::unordered_set<std::string> set2(partition2.begin(), partition2.end());
+    auto& registry = NodeRegistry::instance();
+    std::vector<NodeId> side_a, side_b;
+    for (const auto& id : partition1) {
+        side_a.push_back(registry.intern(id));
+    }
+    for (const auto& id : partition2) {
+        side_b.push_back(registry.intern(id));
+    }
     
-    partitions[partition1[0]] = set1;
-    partitions[partition2[0]] = set2;
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(topology_mutex);
+        change_topology([&](LinkModel& links) { links.split_sides(side_a, side_b); });
+        generation = ++partition_generation;
+    }
+    if (scheduler && duration_ms > 0) {
+        scheduler->schedule_after(duration_ms, [this, generation]() {
+            std::lock_guard<std::mutex> lock(topology_mutex);
+            if (partition_generation == generation) {
+                change_topology([](LinkModel& links) { links.heal_sides(); });
+            }
+        });
+    }
 }
 
 void Network::heal_network_partition() {
-    std::lock_guard<std::mutex> lock(partition_mutex);
-    partitions.clear();
+    std::lock_guard<std::mutex> lock(topology_mutex);
+    change_topology([](LinkModel& links) { links.heal_sides(); });
+    ++partition_generation;
+}
+
+bool Network::load_topology(const std::string& file_path, std::string& error) {
+    std::lock_guard<std::mutex> lock(topology_mutex);
+    bool loaded = false;
+    change_topology([&](LinkModel& links) { loaded = links.load(file_path, error); });
+    return loaded;
+}
+
+bool Network::load_topology(std::istream& in, std::string& error) {
+    std::lock_guard<std::mutex> lock(topology_mutex);
+    bool loaded = false;
+    change_topology([&](LinkModel& links) { loaded = links.parse(in, error); });
+    return loaded;
+}
+
+void Network::clear_topology() {
+    std::lock_guard<std::mutex> lock(topology_mutex);
+    change_topology([](LinkModel& links) { links.clear(); });
+}
+
+void Network::set_default_link(const LinkParams& params) {
+    std::lock_guard<std::mutex> lock(topology_mutex);
+    change_topology([&](LinkModel& links) { links.set_defaults(params); });
+}
+
+bool Network::partition_groups(const std::string& from_group, const std::string& to_group, bool one_way) {
+    std::lock_guard<std::mutex> lock(topology_mutex);
+    const LinkModel& current = *topology.load(std::memory_order_relaxed);
+    int from = current.find_group(from_group);
+    int to = current.find_group(to_group);
+    if (from < 0 || to < 0) {
+        return false;
+    }
+    change_topology([&](LinkModel& links) { links.cut(from, to, one_way); });
+    return true;
+}
+
+void Network::heal_group_partitions() {
+    std::lock_guard<std::mutex> lock(topology_mutex);
+    change_topology([](LinkModel& links) { links.heal_groups(); });
+}
+
+void Network::change_topology(const std::function<void(LinkModel&)>& change) {
+    std::unique_ptr<LinkModel> next;
+    {
+        // The pipe clocks are the one part senders write
+        std::lock_guard<std::mutex> lock(pipe_mutex);
+        next = std::make_unique<LinkModel>(*topology.load(std::memory_order_relaxed));
+    }
+    change(*next);
+    topology.store(next.get(), std::memory_order_release);
+    topology_snapshots.push_back(std::move(next));
+}
+
+void Network::on_processed(const Envelope& envelope, uint64_t queueing_us, uint64_t processing_us) {
+    auto& recorders = latency[static_cast<size_t>(classify(envelope.content))];
+    recorders.queueing_delay_us.record(queueing_us);
+    recorders.processing_us.record(processing_us);
+}
+
+void Network::record_link(NodeId from_id, NodeId to_id, size_t bytes, bool dropped) {
+    uint64_t key = (uint64_t{from_id} << 32) | to_id;
+    auto& shard = link_shards[(from_id ^ to_id) % num_link_shards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto& link = shard.links[key];
+    link.from_id = from_id;
+    link.to_id = to_id;
+    link.sent++;
+    link.bytes += bytes;
+    if (dropped) {
+        link.dropped++;
+    }
+}
+
+void Network::record_link_delay(NodeId from_id, NodeId to_id, uint64_t delay_us) {
+    uint64_t key = (uint64_t{from_id} << 32) | to_id;
+    auto& shard = link_shards[(from_id ^ to_id) % num_link_shards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.links.find(key);
+    if (it != shard.links.end()) {
+        it->second.delivery_delay_us.record(delay_us);
+    }
+}
+
+Network::MessageType Network::classify(const std::string& content) {
+    auto header = [&content](uint8_t magic, uint8_t version) {
+        return content.size() >= 2 && static_cast<uint8_t>(content[0]) == magic &&
+               static_cast<uint8_t>(content[1]) == version;
+    };
+    if (header(GossipEncoder::magic, GossipEncoder::format_version)) {
+        return MessageType::Gossip;
+    }
+    if (header(SwimEncoder::magic, SwimEncoder::format_version)) {
+        return MessageType::Swim;
+    }
+    if (!content.empty() && static_cast<uint8_t>(content[0]) == anti_entropy_magic) {
+        return MessageType::AntiEntropy;
+    }
+    if (content == "HEARTBEAT" || content == "HEARTBEAT_RELEASE") {
+        return MessageType::Heartbeat;
+    }
+    if (content == "HEARTBEAT_ACK" || content == "HEARTBEAT_RELEASE_ACK") {
+        return MessageType::HeartbeatAck;
+    }
+    return MessageType::Other;
+}
+
+const char* Network::message_type_name(MessageType type) {
+    switch (type) {
+        case MessageType::Gossip: return "gossip";
+        case MessageType::Heartbeat: return "heartbeat";
+        case MessageType::HeartbeatAck: return "heartbeat_ack";
+        case MessageType::Swim: return "swim";
+        case MessageType::AntiEntropy: return "anti_entropy";
+        case MessageType::Other: return "other";
+    }
+    return "other";
 }
 
 Network::NetworkStats Network::get_stats() const {
     NetworkStats current_stats;
     current_stats.delivered_messages = stats.delivered_messages.load(std::memory_order_relaxed);
     current_stats.dropped_messages = stats.dropped_messages.load(std::memory_order_relaxed);
+    current_stats.blocked_messages = stats.blocked_messages.load(std::memory_order_relaxed);
     current_stats.total_delay = stats.total_delay.load(std::memory_order_relaxed);
+    current_stats.sent_bytes = stats.sent_bytes.load(std::memory_order_relaxed);
+    current_stats.saved_bytes = stats.saved_bytes.load(std::memory_order_relaxed);
+    current_stats.allocations = stats.allocations.load(std::memory_order_relaxed);
+    current_stats.coalesced_messages = stats.coalesced_messages.load(std::memory_order_relaxed);
+    current_stats.delivery_batches = stats.delivery_batches.load(std::memory_order_relaxed);
+    for (size_t type = 0; type < message_type_count; ++type) {
+        auto& by_type = current_stats.by_type[type];
+        by_type.delivery_delay_us = latency[type].delivery_delay_us.snapshot();
+        by_type.queueing_delay_us = latency[type].queueing_delay_us.snapshot();
+        by_type.processing_us = latency[type].processing_us.snapshot();
+        current_stats.overall.delivery_delay_us.merge(by_type.delivery_delay_us);
+        current_stats.overall.queueing_delay_us.merge(by_type.queueing_delay_us);
+        current_stats.overall.processing_us.merge(by_type.processing_us);
+    }
+    for (auto& shard : link_shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& entry : shard.links) {
+            current_stats.links.push_back(entry.second);
+        }
+    }
     return current_stats;
 }
 
 void Network::reset_stats() {
     stats.delivered_messages.store(0, std::memory_order_relaxed);
     stats.dropped_messages.store(0, std::memory_order_relaxed);
+    stats.blocked_messages.store(0, std::memory_order_relaxed);
     stats.total_delay.store(0.0, std::memory_order_relaxed);
+    stats.sent_bytes.store(0, std::memory_order_relaxed);
+    stats.saved_bytes.store(0, std::memory_order_relaxed);
+    stats.allocations.store(0, std::memory_order_relaxed);
+    stats.coalesced_messages.store(0, std::memory_order_relaxed);
+    stats.delivery_batches.store(0, std::memory_order_relaxed);
+    for (auto& recorders : latency) {
+        recorders.delivery_delay_us.reset();
+        recorders.queueing_delay_us.reset();
+        recorders.processing_us.reset();
+    }
+    for (auto& shard : link_shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.links.clear();
+    }
+}
+
+void Network::set_seed(uint64_t seed) {
+    this->seed.store(seed, std::memory_order_relaxed);
+    for (auto& stream : send_streams) {
+        stream.seq.store(0, std::memory_order_relaxed);
+    }
+}
+
+void Network::set_trace(TraceRecorder* recorder) {
+    trace = recorder;
+    std::lock_guard<std::mutex> lock(nodes_mutex);
+    for (auto& node : nodes) {
+        if (node) {
+            node->attach_trace(recorder);
+        }
+    }
 }
 
-bool Network::should_drop_message() {
-    return loss_dist(rng) < message_loss_rate;
+Network::Route Network::route(NodeId from_id, NodeId to_id, size_t bytes, double now_ms, int& delay_ms) {
+    // Faults and link lookup are settled on the snapshot alone
+    const LinkModel& links = *topology.load(std::memory_order_acquire);
+    if (links.is_blocked(from_id, to_id)) {
+        return Route::Blocked;
+    }
+    size_t link = links.link_index(from_id, to_id);
+    const LinkParams& params = links.get_link(link);
+    uint64_t seq = send_streams[from_id % num_send_streams].seq.fetch_add(1, std::memory_order_relaxed);
+    uint64_t bits = splitmix64(seed.load(std::memory_order_relaxed) ^ (uint64_t{from_id} << 40) ^ seq);
+    if (unit(bits) < params.loss_rate) {
+        return Route::Lost;
+    }
+    // Box-Muller on two more draws from the same stream
+    double u1 = std::max(unit(splitmix64(bits)), 1e-12);
+    double u2 = unit(splitmix64(bits ^ 0x5851f42d4c957f2dULL));
+    double normal = std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+    double propagation = std::max(0.0, params.mean_delay_ms + params.std_dev_delay_ms * normal);
+    double queueing = 0.0;
+    if (params.bandwidth_bytes_per_s > 0.0) {
+        std::lock_guard<std::mutex> lock(pipe_mutex);
+        queueing = links.reserve(link, bytes, now_ms);
+    }
+    delay_ms = static_cast<int>(propagation + queueing);
+    return Route::Deliver;
 }
 
-int Network::calculate_delay() {
-    return std::max(0, static_cast<int>(delay_dist(rng)));
+std::chrono::system_clock::time_point Network::get_current_time() const {
+    return scheduler ? scheduler->now() : std::chrono::system_clock::now();
 }
 
 void Network::update_stats(int delay, bool dropped) {
@@ -111,7 +656,10 @@ void Network::update_stats(int delay, bool dropped) {
         stats.dropped_messages.fetch_add(1, std::memory_order_relaxed);
     } else {
         stats.delivered_messages.fetch_add(1, std::memory_order_relaxed);
+        // No fetch_add for atomic<double> before C++20; retry so concurrent senders never lose a delay
         double current_delay = stats.total_delay.load(std::memory_order_relaxed);
-        stats.total_delay.store(current_delay + delay, std::memory_order_relaxed);
+        while (!stats.total_delay.compare_exchange_weak(current_delay, current_delay + delay,
+                                                        std::memory_order_relaxed)) {
+        }
     }
 } 
\ No newline at end of file
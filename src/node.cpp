@@ -1,10 +1,24 @@
 #include "node.hpp"
+#include <algorithm>
 
-Node::Node(const std::string& node_id) 
-    : id(node_id), is_alive(true), is_running(false) {}
+Node::Node(const std::string& node_id, std::shared_ptr<TaskScheduler> task_scheduler)
+    : id(node_id), numeric_id(NodeRegistry::instance().intern(node_id)), is_alive(true),
+      is_running(false), scheduler(std::move(task_scheduler)), transport(nullptr), trace(nullptr), observer(nullptr),
+      max_queue_depth(0), drained_messages(0), drain_batches(0), total_drain_us(0), max_drain_us(0) {}
 
 Node::~Node() {
     stop();
+    // The inbox does not own its envelopes
+    inbox.drain([](Envelope* envelope) { EnvelopePool::instance().release(envelope); });
+}
+
+void Node::start() {
+    is_running = true;
+    if (scheduler) {
+        schedule_tick();
+    } else {
+        node_thread = std::thread(&Node::run, this);
+    }
 }
 
 void Node::stop() {
@@ -15,28 +29,167 @@ void Node::stop() {
 }
 
 void Node::receive_message(const std::string& from_id, const std::string& content) {
-    Message msg{from_id, content, get_current_time()};
-    std::lock_guard<std::mutex> lock(queue_mutex);
-    message_queue.push(msg);
+    receive_message(NodeRegistry::instance().intern(from_id), content);
+}
+
+void Node::receive_message(NodeId from_id, const std::string& content) {
+    if (!is_alive) {
+        return;  // A crashed node neither receives nor acts
+    }
+    uint64_t allocations = 0;
+    Envelope* envelope = EnvelopePool::instance().acquire(allocations);
+    envelope->from_id = from_id;
+    envelope->to_id = numeric_id;
+    envelope->content = content;
+    envelope->sent_time = get_current_time();
+    receive_envelope(envelope);
+}
+
+void Node::receive_envelope(Envelope* envelope) {
+    receive_batch(&envelope, 1);
+}
+
+void Node::receive_batch(Envelope* const* envelopes, size_t count) {
+    if (!is_alive) {
+        for (size_t i = 0; i < count; ++i) {
+            EnvelopePool::instance().release(envelopes[i]);  // A crashed node neither receives nor acts
+        }
+        return;
+    }
+    auto now = get_current_time();
+    for (size_t i = 0; i < count; ++i) {
+        envelopes[i]->timestamp = now;
+    }
+    size_t depth = inbox.push_all(envelopes, count);
+    size_t peak = max_queue_depth.load(std::memory_order_relaxed);
+    while (depth > peak && !max_queue_depth.compare_exchange_weak(peak, depth, std::memory_order_relaxed)) {
+    }
 }
 
 void Node::process_message_queue() {
-    std::lock_guard<std::mutex> lock(queue_mutex);
-    while (!message_queue.empty()) {
-        Message msg = message_queue.front();
-        message_queue.pop();
-        process_message(msg);
+    // Senders never touch drain_mutex; it only keeps the inbox single-consumer
+    std::lock_guard<std::mutex> lock(drain_mutex);
+    if (inbox.empty()) {
+        return;
     }
+    
+    auto start = std::chrono::steady_clock::now();
+    Transport* target = transport;
+    auto drain_time = get_current_time();
+    size_t batch_size = inbox.drain([this, target, drain_time](Envelope* envelope) {
+        if (target) {
+            auto begin = std::chrono::steady_clock::now();
+            process_message(*envelope);
+            auto processing = std::chrono::steady_clock::now() - begin;
+            auto queued = std::max(drain_time - envelope->timestamp, std::chrono::system_clock::duration::zero());
+            target->on_processed(*envelope,
+                                 std::chrono::duration_cast<std::chrono::microseconds>(queued).count(),
+                                 std::chrono::duration_cast<std::chrono::microseconds>(processing).count());
+        } else {
+            process_message(*envelope);
+        }
+        EnvelopePool::instance().release(envelope);
+    });
+    uint64_t drain_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    
+    drained_messages += batch_size;
+    drain_batches++;
+    total_drain_us += drain_us;
+    if (drain_us > max_drain_us) {
+        max_drain_us = drain_us;  // Only the single consumer writes this
+    }
+}
+
+Node::InboxStats Node::get_inbox_stats() const {
+    return InboxStats{inbox.size(), max_queue_depth.load(), drained_messages.load(),
+                      drain_batches.load(), total_drain_us.load(), max_drain_us.load()};
 }
 
 void Node::run() {
     while (is_running) {
+        run_tick();
+        std::this_thread::sleep_for(std::chrono::milliseconds(tick_interval_ms));
+    }
+}
+
+void Node::run_tick() {
+    if (is_alive) {
         process_message_queue();
         periodic_task();
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        flush_outbox();
     }
 }
 
+void Node::tick() {
+    run_tick();
+    schedule_tick();
+}
+
+void Node::schedule_tick() {
+    // Hold only a weak reference so pending events never keep a removed node alive.
+    // Scheduled nodes must therefore be owned by a shared_ptr.
+    std::weak_ptr<Node> self = weak_from_this();
+    scheduler->schedule_after(tick_interval_ms, [self]() {
+        auto node = self.lock();
+        if (node && node->is_running) {
+            node->tick();
+        }
+    });
+}
+
+void Node::report_view_change(NodeId subject, bool failed) {
+    TraceRecorder* recorder = trace;
+    MembershipObserver* target = observer;
+    if (!recorder && !target) {
+        return;
+    }
+    int64_t now_ms = get_current_time_ms();
+    if (recorder) {
+        recorder->record(failed ? TraceEvent::Suspect : TraceEvent::Clear, now_ms, numeric_id, subject);
+    }
+    if (target) {
+        target->on_view_change(numeric_id, subject, failed, now_ms);
+    }
+}
+
+void Node::transmit(NodeId to_id, const std::string& content, size_t full_state_bytes) {
+    Transport* target = transport;
+    if (!target || !is_alive) {
+        return;
+    }
+    if (!coalescing) {
+        target->send_message(numeric_id, to_id, content, full_state_bytes);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(outbox_mutex);
+    if (outbox_size == outbox.size()) {
+        outbox.emplace_back();
+    }
+    auto& message = outbox[outbox_size++];
+    message.to_id = to_id;
+    message.content.assign(content);
+    message.full_state_bytes = full_state_bytes;
+}
+
+void Node::flush_outbox() {
+    if (!coalescing) {
+        return;
+    }
+    // Held across the send so a concurrent transmit never sees a half-flushed outbox
+    std::lock_guard<std::mutex> lock(outbox_mutex);
+    Transport* target = transport;
+    if (target && outbox_size > 0) {
+        target->send_batch(numeric_id, outbox.data(), outbox_size);
+    }
+    outbox_size = 0;
+}
+
 std::chrono::system_clock::time_point Node::get_current_time() const {
-    return std::chrono::system_clock::now();
+    return scheduler ? scheduler->now() : std::chrono::system_clock::now();
+}
+
+int64_t Node::get_current_time_ms() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        get_current_time().time_since_epoch()).count();
 } 
\ No newline at end of file
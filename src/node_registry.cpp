@@ -0,0 +1,41 @@
+#include "node_registry.hpp"
+#include <mutex>
+
+NodeRegistry& NodeRegistry::instance() {
+    static NodeRegistry registry;
+    return registry;
+}
+
+NodeId NodeRegistry::intern(const std::string& name) {
+    {
+        std::shared_lock<std::shared_mutex> lock(registry_mutex);
+        auto it = ids.find(name);
+        if (it != ids.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(registry_mutex);
+    auto [it, inserted] = ids.try_emplace(name, static_cast<NodeId>(names.size()));
+    if (inserted) {
+        names.push_back(name);
+    }
+    return it->second;
+}
+
+NodeId NodeRegistry::find(const std::string& name) const {
+    std::shared_lock<std::shared_mutex> lock(registry_mutex);
+    auto it = ids.find(name);
+    return (it != ids.end()) ? it->second : invalid_node_id;
+}
+
+const std::string& NodeRegistry::name(NodeId id) const {
+    static const std::string unknown;
+    std::shared_lock<std::shared_mutex> lock(registry_mutex);
+    return (id < names.size()) ? names[id] : unknown;
+}
+
+size_t NodeRegistry::size() const {
+    std::shared_lock<std::shared_mutex> lock(registry_mutex);
+    return names.size();
+}
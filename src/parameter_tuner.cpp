@@ -0,0 +1,176 @@
+#include "parameter_tuner.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <set>
+
+ParameterTuner::ParameterTuner(size_t threads, int refine_rounds)
+    : runner(threads), refine_rounds(std::max(0, refine_rounds)) {}
+
+std::vector<ParameterTuner::Point> ParameterTuner::evaluate(const ScenarioScript& script,
+                                                            const std::vector<DetectorParams>& candidates,
+                                                            uint64_t base_seed) {
+    // One task per (point, seed); every point sees the same seeds
+    std::vector<std::function<Simulator::TestResult()>> tasks;
+    for (const auto& params : candidates) {
+        for (int s = 0; s < script.seeds; ++s) {
+            tasks.push_back([&script, params, seed = base_seed + s]() {
+                Simulator simulator(Simulator::ExecutionMode::VirtualTime);
+                simulator.set_seed(seed);
+                ScenarioScript run = script;
+                run.params = params;
+                return simulator.run_scenario(run);
+            });
+        }
+    }
+    auto results = runner.run_tasks(tasks);
+    
+    std::vector<Point> points;
+    for (size_t p = 0; p < candidates.size(); ++p) {
+        Point point{candidates[p], 0, 0, 0, 0, 0, true, false};
+        bool every_crash_detected = true;
+        for (int s = 0; s < script.seeds; ++s) {
+            const auto& result = results[p * script.seeds + s];
+            // NaN latencies (a crash not every observer saw) carry into the means rather than counting as 0 ms
+            every_crash_detected = every_crash_detected && !std::isnan(result.last_detection_ms);
+            double seconds = std::max(result.measured_ms, 1.0) / 1000.0;
+            point.median_detection_ms += result.median_detection_ms / script.seeds;
+            point.last_detection_ms += result.last_detection_ms / script.seeds;
+            point.bytes_per_node_s += result.bytes_sent / (script.num_nodes * seconds) / script.seeds;
+            point.mistake_rate += result.mistake_rate / script.seeds;
+            point.false_negatives += result.false_negatives;
+        }
+        point.feasible = every_crash_detected && point.false_negatives == 0 &&
+                         (script.max_bytes_per_node_s <= 0 || point.bytes_per_node_s <= script.max_bytes_per_node_s) &&
+                         (script.max_mistake_rate <= 0 || point.mistake_rate <= script.max_mistake_rate);
+        points.push_back(point);
+    }
+    return points;
+}
+
+bool ParameterTuner::better(const Point& a, const Point& b) {
+    if (a.feasible != b.feasible) {
+        return a.feasible;
+    }
+    if (a.median_detection_ms != b.median_detection_ms) {
+        return a.median_detection_ms < b.median_detection_ms;
+    }
+    return a.bytes_per_node_s < b.bytes_per_node_s;  // Same latency: the cheaper one
+}
+
+ParameterTuner::Report ParameterTuner::tune(const ScenarioScript& script, uint64_t base_seed) {
+    Report report;
+    report.scenario = script.name;
+    for (const auto& axis : script.tune) {
+        report.axes.push_back(axis.param);
+    }
+    
+    // Full grid over the tune axes; untuned parameters keep the script's values
+    std::vector<DetectorParams> grid = {script.params};
+    for (const auto& axis : script.tune) {
+        std::vector<DetectorParams> expanded;
+        for (const auto& params : grid) {
+            for (int value : axis.values) {
+                DetectorParams point = params;
+                *point.field(axis.param) = value;
+                expanded.push_back(point);
+            }
+        }
+        grid = expanded;
+    }
+    report.points = evaluate(script, grid, base_seed);
+    
+    auto key = [&](const DetectorParams& params) {
+        std::vector<int> values;
+        for (const auto& axis : script.tune) {
+            values.push_back(params.get(axis.param));
+        }
+        return values;
+    };
+    std::set<std::vector<int>> seen;
+    std::vector<std::set<int>> tried(script.tune.size());  // Values evaluated per axis
+    for (const auto& point : report.points) {
+        seen.insert(key(point.params));
+    }
+    for (size_t a = 0; a < script.tune.size(); ++a) {
+        tried[a].insert(script.tune[a].values.begin(), script.tune[a].values.end());
+    }
+    
+    size_t best = 0;
+    for (size_t i = 1; i < report.points.size(); ++i) {
+        if (better(report.points[i], report.points[best])) {
+            best = i;
+        }
+    }
+    
+    // Bisect between the best value and its nearest tried neighbours on each axis
+    for (int round = 0; round < refine_rounds && !report.points.empty() && report.points[best].feasible; ++round) {
+        std::vector<DetectorParams> candidates;
+        for (size_t a = 0; a < script.tune.size(); ++a) {
+            const std::string& param = script.tune[a].param;
+            int current = report.points[best].params.get(param);
+            auto at = tried[a].find(current);
+            std::vector<int> neighbours;
+            if (at != tried[a].begin()) {
+                neighbours.push_back(*std::prev(at));
+            }
+            if (std::next(at) != tried[a].end()) {
+                neighbours.push_back(*std::next(at));
+            }
+            for (int neighbour : neighbours) {
+                DetectorParams candidate = report.points[best].params;
+                *candidate.field(param) = current + (neighbour - current) / 2;
+                if (seen.insert(key(candidate)).second) {
+                    tried[a].insert(candidate.get(param));
+                    candidates.push_back(candidate);
+                }
+            }
+        }
+        if (candidates.empty()) {
+            break;
+        }
+        for (auto point : evaluate(script, candidates, base_seed)) {
+            point.refined = true;
+            report.points.push_back(point);
+            if (better(point, report.points[best])) {
+                best = report.points.size() - 1;
+            }
+        }
+    }
+    
+    report.found = !report.points.empty() && report.points[best].feasible;
+    if (!report.points.empty()) {
+        report.best = report.points[best];
+    }
+    return report;
+}
+
+void ParameterTuner::print(const Report& report) {
+    auto describe = [&](const DetectorParams& params) {
+        std::string text;
+        for (const auto& axis : report.axes) {
+            text += (text.empty() ? "" : " ") + axis + "=" + std::to_string(params.get(axis));
+        }
+        return text;
+    };
+    
+    std::cout << "Tuning " << report.scenario << " (" << report.points.size() << " points)\n"
+              << std::fixed << std::setprecision(1);
+    for (const auto& point : report.points) {
+        std::cout << "  " << (point.refined ? "bisect " : "grid   ") << describe(point.params)
+                  << ": median " << Simulator::format_ms(point.median_detection_ms) << ", last "
+                  << Simulator::format_ms(point.last_detection_ms) << ", " << point.bytes_per_node_s << " B/node/s, " << std::setprecision(4)
+                  << point.mistake_rate << " mistakes/pair/s" << std::setprecision(1)
+                  << (point.false_negatives > 0 ? ", missed " + std::to_string(point.false_negatives) : "")
+                  << (point.feasible ? "" : " (infeasible)") << "\n";
+    }
+    if (report.found) {
+        std::cout << "Best: " << describe(report.best.params) << " (median detection "
+                  << report.best.median_detection_ms << "ms)\n";
+    } else {
+        std::cout << "No point met every budget\n";
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+}
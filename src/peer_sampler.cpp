@@ -0,0 +1,121 @@
+#include "peer_sampler.hpp"
+#include <algorithm>
+
+PeerSampler::PeerSampler(NodeId self) : self(self) {}
+
+size_t PeerSampler::pool_for(NodeId id) const {
+    return strategy == Strategy::ZoneAware && zone_of(id) != zone_of(self) ? 1 : 0;
+}
+
+void PeerSampler::place(Pool& pool, size_t index, NodeId id) {
+    pool.ids[index] = id;
+    slots[id].index = static_cast<uint32_t>(index);
+}
+
+void PeerSampler::insert(NodeId id) {
+    size_t which = pool_for(id);
+    auto& pool = pools[which];
+    // New peers land in the unvisited part of the current pass
+    slots[id] = Slot{static_cast<uint32_t>(pool.ids.size()), static_cast<uint8_t>(which), true};
+    pool.ids.push_back(id);
+}
+
+void PeerSampler::erase(NodeId id) {
+    auto& pool = pools[slots[id].pool];
+    size_t index = slots[id].index;
+    if (index < pool.cursor) {
+        // Keep the visited prefix contiguous so no unvisited peer gets skipped
+        --pool.cursor;
+        place(pool, index, pool.ids[pool.cursor]);
+        index = pool.cursor;
+    }
+    place(pool, index, pool.ids.back());
+    pool.ids.pop_back();
+    slots[id].present = false;
+}
+
+void PeerSampler::rebuild() {
+    std::vector<NodeId> peers;
+    for (auto& pool : pools) {
+        peers.insert(peers.end(), pool.ids.begin(), pool.ids.end());
+        pool.ids.clear();
+        pool.cursor = 0;
+    }
+    for (NodeId id : peers) {
+        insert(id);
+    }
+}
+
+void PeerSampler::set_strategy(Strategy value) {
+    strategy = value;
+    rebuild();
+}
+
+void PeerSampler::set_zone(NodeId id, int zone) {
+    if (id >= zones.size()) {
+        zones.resize(static_cast<size_t>(id) + 1, 0);
+    }
+    zones[id] = zone;
+    if (id == self) {
+        rebuild();
+    } else if (contains(id) && slots[id].pool != pool_for(id)) {
+        erase(id);
+        insert(id);
+    }
+}
+
+void PeerSampler::add(NodeId id) {
+    if (id == self || id == invalid_node_id || contains(id)) {
+        return;
+    }
+    if (id >= slots.size()) {
+        slots.resize(static_cast<size_t>(id) + 1, Slot{0, 0, false});
+    }
+    insert(id);
+}
+
+void PeerSampler::remove(NodeId id) {
+    if (contains(id)) {
+        erase(id);
+    }
+}
+
+void PeerSampler::draw(Pool& pool, size_t count, std::mt19937& rng) {
+    size_t size = pool.ids.size();
+    if (strategy == Strategy::Random) {
+        pool.cursor = 0;  // Every round starts a new shuffle
+    }
+    // After a pass wraps, the peers picked just before it sit at the end; keep them
+    // out of reach until this round is done so nobody is picked twice
+    size_t limit = size;
+    for (size_t picked = 0; picked < count && picked < size; ++picked) {
+        if (pool.cursor == size) {
+            pool.cursor = 0;
+            limit = size - picked;
+        }
+        std::uniform_int_distribution<size_t> dist(pool.cursor, limit - 1);
+        size_t index = dist(rng);
+        NodeId chosen = pool.ids[index];
+        place(pool, index, pool.ids[pool.cursor]);
+        place(pool, pool.cursor, chosen);
+        ++pool.cursor;
+        selected.push_back(chosen);
+    }
+}
+
+const std::vector<NodeId>& PeerSampler::select(size_t count, std::mt19937& rng) {
+    selected.clear();
+    if (strategy != Strategy::ZoneAware) {
+        draw(pools[0], count, rng);
+        return selected;
+    }
+    
+    // One remote pick keeps zones from drifting apart; the local pool takes the rest
+    // and the remote pool tops up when our zone is too small
+    auto& local = pools[0];
+    auto& remote = pools[1];
+    size_t remote_count = remote.ids.empty() || count == 0 ? 0 : 1;
+    draw(local, std::min(count - remote_count, local.ids.size()), rng);
+    draw(remote, count - selected.size(), rng);
+    return selected;
+}
@@ -0,0 +1,112 @@
+#include "phi_accrual_detector.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+double phi_for(double elapsed, double mean, double stddev) {
+    // Logistic approximation of the normal CDF (error below 1e-4), evaluated on
+    // the side that avoids cancellation for large y
+    double y = (elapsed - mean) / stddev;
+    double e = std::exp(-y * (1.5976 + 0.070566 * y * y));
+    if (elapsed > mean) {
+        return -std::log10(e / (1.0 + e));
+    }
+    return -std::log10(1.0 - 1.0 / (1.0 + e));
+}
+}
+
+PhiAccrualDetector::PhiAccrualDetector(size_t window_size, double first_interval_ms, double min_stddev_ms,
+                                       double acceptable_pause_ms)
+    : window_size(std::max<size_t>(window_size, 1)), first_interval_ms(first_interval_ms),
+      min_stddev_ms(min_stddev_ms), acceptable_pause_ms(acceptable_pause_ms) {}
+
+void PhiAccrualDetector::heartbeat(NodeId id, int64_t now_ms) {
+    if (id >= windows.size()) {
+        windows.resize(static_cast<size_t>(id) + 1);
+    }
+    Window& window = windows[id];
+    if (window.intervals.empty()) {
+        window.intervals.resize(window_size);
+    }
+
+    if (window.last_arrival_ms >= 0 && now_ms > window.last_arrival_ms) {
+        int64_t interval = now_ms - window.last_arrival_ms;
+        if (window.count == window_size) {
+            // Evict the oldest sample from the running sums
+            double oldest = static_cast<double>(window.intervals[window.next]);
+            window.sum -= oldest;
+            window.sum_squares -= oldest * oldest;
+        } else {
+            window.count++;
+        }
+        window.intervals[window.next] = interval;
+        window.next = (window.next + 1) % window_size;
+        window.sum += static_cast<double>(interval);
+        window.sum_squares += static_cast<double>(interval) * interval;
+    }
+    window.last_arrival_ms = std::max(window.last_arrival_ms, now_ms);
+}
+
+double PhiAccrualDetector::phi(NodeId id, int64_t now_ms) const {
+    if (id >= windows.size() || windows[id].last_arrival_ms < 0) {
+        return 0.0;  // Never heard from, nothing to accrue against
+    }
+    double elapsed = static_cast<double>(now_ms - windows[id].last_arrival_ms);
+    return phi_for(elapsed, mean_interval(id) + acceptable_pause_ms, stddev_interval(id));
+}
+
+int64_t PhiAccrualDetector::suspicion_deadline(NodeId id, double threshold) const {
+    if (id >= windows.size() || windows[id].last_arrival_ms < 0) {
+        return std::numeric_limits<int64_t>::max();  // phi stays 0 until the first heartbeat
+    }
+    double mean = mean_interval(id) + acceptable_pause_ms;
+    double stddev = stddev_interval(id);
+
+    // phi only grows with elapsed time, so bisect for the first whole ms above the threshold
+    int64_t low = 0;
+    int64_t high = static_cast<int64_t>(mean + stddev) + 1;
+    while (phi_for(static_cast<double>(high), mean, stddev) <= threshold) {
+        if (high > (int64_t{1} << 40)) {
+            return std::numeric_limits<int64_t>::max();
+        }
+        low = high;
+        high *= 2;
+    }
+    while (high - low > 1) {
+        int64_t mid = low + (high - low) / 2;
+        if (phi_for(static_cast<double>(mid), mean, stddev) > threshold) {
+            high = mid;
+        } else {
+            low = mid;
+        }
+    }
+    return windows[id].last_arrival_ms + low;  // phi > threshold once now passes this
+}
+
+void PhiAccrualDetector::remove(NodeId id) {
+    if (id < windows.size()) {
+        windows[id] = Window();
+    }
+}
+
+double PhiAccrualDetector::mean_interval(NodeId id) const {
+    if (id >= windows.size() || windows[id].count == 0) {
+        return first_interval_ms;
+    }
+    return windows[id].sum / windows[id].count;
+}
+
+double PhiAccrualDetector::stddev_interval(NodeId id) const {
+    if (id >= windows.size() || windows[id].count < 2) {
+        return std::max(min_stddev_ms, first_interval_ms / 4);
+    }
+    const Window& window = windows[id];
+    double mean = window.sum / window.count;
+    double variance = std::max(0.0, window.sum_squares / window.count - mean * mean);
+    return std::max(min_stddev_ms, std::sqrt(variance));
+}
+
+size_t PhiAccrualDetector::sample_count(NodeId id) const {
+    return id < windows.size() ? windows[id].count : 0;
+}
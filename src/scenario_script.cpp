@@ -0,0 +1,184 @@
+#include "scenario_script.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace {
+bool parse_int(const std::string& word, int& value) {
+    char* end = nullptr;
+    long parsed = std::strtol(word.c_str(), &end, 10);
+    if (word.empty() || *end != '\0' || parsed < 0 || parsed > 1000000000) {
+        return false;
+    }
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+bool parse_double(const std::string& word, double& value) {
+    char* end = nullptr;
+    value = std::strtod(word.c_str(), &end);
+    return !word.empty() && *end == '\0' && value >= 0;
+}
+}
+
+bool ScenarioScript::parse(std::istream& in, std::string& error, const std::string& base_dir) {
+    std::string line;
+    int line_number = 0;
+    while (std::getline(in, line)) {
+        ++line_number;
+        line = line.substr(0, line.find('#'));
+        std::istringstream words(line);
+        std::string keyword;
+        if (!(words >> keyword)) {
+            continue;
+        }
+        std::vector<std::string> args;
+        for (std::string word; words >> word;) {
+            args.push_back(word);
+        }
+        auto fail = [&](const std::string& message) {
+            error = "line " + std::to_string(line_number) + ": " + message;
+            return false;
+        };
+        
+        int value = 0;
+        if (keyword == "name") {
+            if (args.empty()) {
+                return fail("name needs a label");
+            }
+            name = line.substr(line.find("name") + 4);
+            name = name.substr(name.find_first_not_of(" \t"));
+            name = name.substr(0, name.find_last_not_of(" \t\r") + 1);
+        } else if (keyword == "algorithm") {
+            if (args.size() != 1) {
+                return fail("algorithm needs gossip, heartbeat or swim");
+            }
+            if (args[0] == "gossip") {
+                algorithm = Simulator::Algorithm::Gossip;
+            } else if (args[0] == "heartbeat") {
+                algorithm = Simulator::Algorithm::Heartbeat;
+            } else if (args[0] == "swim") {
+                algorithm = Simulator::Algorithm::Swim;
+            } else {
+                return fail("unknown algorithm '" + args[0] + "'");
+            }
+        } else if (keyword == "nodes") {
+            if (args.size() != 1 || !parse_int(args[0], num_nodes) || num_nodes < 2) {
+                return fail("nodes needs a count of at least 2");
+            }
+        } else if (keyword == "set") {
+            int* field = args.size() == 2 ? params.field(args[0]) : nullptr;
+            if (!field) {
+                return fail("set needs a known parameter and a value");
+            }
+            if (!parse_int(args[1], value) || value < 1) {
+                return fail("parameter values are positive integers");
+            }
+            *field = value;
+        } else if (keyword == "network") {
+            std::istringstream options(line.substr(line.find("network") + 7));
+            bool one_way = false;
+            std::string detail;
+            if (!LinkModel::parse_options(options, network, one_way, detail)) {
+                return fail(detail);
+            }
+            has_network = true;
+        } else if (keyword == "topology") {
+            if (args.size() != 1) {
+                return fail("topology needs a file");
+            }
+            topology_path = args[0][0] == '/' || base_dir.empty() ? args[0] : base_dir + "/" + args[0];
+            LinkModel check;
+            std::string detail;
+            if (!check.load(topology_path, detail)) {
+                return fail(detail);
+            }
+        } else if (keyword == "warmup") {
+            if (args.size() != 1 || !parse_int(args[0], warmup_ms)) {
+                return fail("warmup needs milliseconds");
+            }
+        } else if (keyword == "crash" || keyword == "recover") {
+            Step step{keyword == "crash" ? Action::Crash : Action::Recover, 0, {}, {}, false};
+            if (args.empty()) {
+                return fail(keyword + " needs targets");
+            }
+            if (args.size() == 1 && keyword == "crash" && parse_int(args[0], step.count)) {
+                // Random picks
+            } else if (args.size() == 1 && keyword == "recover" && args[0] == "all") {
+                step.all = true;
+            } else {
+                step.nodes = args;
+            }
+            steps.push_back(step);
+        } else if (keyword == "partition") {
+            Step step{Action::Partition, 0, {}, {}, false};
+            if (args.size() == 1 && args[0] == "half") {
+                step.all = true;
+            } else {
+                bool second = false;
+                for (const auto& arg : args) {
+                    if (arg == "/") {
+                        second = true;
+                    } else {
+                        (second ? step.other : step.nodes).push_back(arg);
+                    }
+                }
+                if (step.nodes.empty() || step.other.empty()) {
+                    return fail("partition needs 'half' or NODE... / NODE...");
+                }
+            }
+            steps.push_back(step);
+        } else if (keyword == "heal") {
+            steps.push_back(Step{Action::Heal, 0, {}, {}, false});
+        } else if (keyword == "wait" || keyword == "wait-detection" || keyword == "wait-convergence") {
+            Action action = keyword == "wait" ? Action::Wait
+                          : keyword == "wait-detection" ? Action::WaitDetection : Action::WaitConvergence;
+            if (args.size() != 1 || !parse_int(args[0], value)) {
+                return fail(keyword + " needs milliseconds");
+            }
+            steps.push_back(Step{action, value, {}, {}, false});
+        } else if (keyword == "tune") {
+            TuneAxis axis;
+            if (args.size() < 2 || !params.field(args[0])) {
+                return fail("tune needs a known parameter and values");
+            }
+            axis.param = args[0];
+            for (size_t i = 1; i < args.size(); ++i) {
+                if (!parse_int(args[i], value) || value < 1) {
+                    return fail("parameter values are positive integers");
+                }
+                axis.values.push_back(value);
+            }
+            tune.push_back(axis);
+        } else if (keyword == "budget") {
+            double limit = 0;
+            if (args.size() != 2 || !parse_double(args[1], limit)) {
+                return fail("budget needs a kind and a limit");
+            }
+            if (args[0] == "bytes_per_node_s") {
+                max_bytes_per_node_s = limit;
+            } else if (args[0] == "mistake_rate") {
+                max_mistake_rate = limit;
+            } else {
+                return fail("unknown budget '" + args[0] + "'");
+            }
+        } else if (keyword == "seeds") {
+            if (args.size() != 1 || !parse_int(args[0], seeds) || seeds < 1) {
+                return fail("seeds needs a positive count");
+            }
+        } else {
+            return fail("unknown keyword '" + keyword + "'");
+        }
+    }
+    return true;
+}
+
+bool ScenarioScript::load(const std::string& file_path, std::string& error) {
+    std::ifstream in(file_path);
+    if (!in) {
+        error = "cannot open " + file_path;
+        return false;
+    }
+    size_t slash = file_path.find_last_of('/');
+    return parse(in, error, slash == std::string::npos ? "" : file_path.substr(0, slash));
+}
@@ -0,0 +1,430 @@
+#include "sharded_simulator.hpp"
+#include "event_scheduler.hpp"
+#include "gossip_node.hpp"
+#include "shm_ring.hpp"
+#include "transport.hpp"
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+
+namespace {
+
+// Lives in the shared mapping; a sense-free generation barrier
+struct SharedControl {
+    alignas(64) std::atomic<uint32_t> arrived;
+    alignas(64) std::atomic<uint32_t> generation;
+};
+
+struct ShardReport {
+    uint64_t messages_sent;
+    uint64_t cross_shard_messages;
+    uint64_t dropped_messages;
+    int32_t detected_pairs;
+    int32_t expected_pairs;
+    int32_t false_positive_pairs;
+    int32_t windows;
+};
+
+// Fixed-size prefix of every cross-shard record
+struct WireHeader {
+    uint32_t from_id;
+    uint32_t to_id;
+    int64_t delivery_ms;
+    uint64_t seq;
+};
+
+size_t align64(size_t value) {
+    return (value + 63) & ~size_t{63};
+}
+
+uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+double unit(uint64_t bits) {
+    return static_cast<double>(bits >> 11) * (1.0 / 9007199254740992.0);  // [0, 1)
+}
+
+std::string node_name(int index) {
+    return "shard_node" + std::to_string(index);
+}
+
+class ShardProcess : public Transport {
+private:
+    // Same loss and delay model as Network, with delays clamped to the window
+    const double message_loss_rate = 0.1;
+    const double mean_delay = 50.0;
+    const double std_dev_delay = 10.0;
+
+    const ShardedSimulator::Config& config;
+    int shard;
+    SharedControl* control;
+    ShardReport* report;
+    int64_t* first_detection_ms;           // One slot per crashed node
+    std::vector<ShmRing> outgoing;         // Indexed by destination shard
+    std::vector<ShmRing> incoming;         // Indexed by source shard
+    std::vector<int> shard_of;             // Indexed by NodeId
+    std::vector<uint64_t> send_seq;        // Indexed by NodeId, local senders only
+    std::vector<std::shared_ptr<GossipNode>> local_nodes;  // Indexed by NodeId
+    std::vector<NodeId> observers;         // Local nodes that are never crashed
+    std::vector<NodeId> crashed;
+    std::vector<bool> is_crashed;          // Indexed by NodeId
+    std::shared_ptr<EventScheduler> scheduler;
+
+    struct PendingMessage {
+        int64_t delivery_ms;
+        NodeId from_id;
+        NodeId to_id;
+        uint64_t seq;
+        Envelope* envelope;
+    };
+    std::vector<PendingMessage> pending;  // Arrived from other shards, not yet scheduled
+
+    static TaskScheduler::TimePoint at_ms(int64_t ms) {
+        return TaskScheduler::TimePoint{} + std::chrono::milliseconds(ms);
+    }
+
+    int64_t now_ms() const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            scheduler->now().time_since_epoch()).count();
+    }
+
+    void deliver(Envelope* envelope) {
+        auto& node = local_nodes[envelope->to_id];
+        if (node) {
+            node->receive_envelope(envelope);
+        } else {
+            EnvelopePool::instance().release(envelope);
+        }
+    }
+
+    void drain_incoming() {
+        uint64_t allocations = 0;
+        for (auto& ring : incoming) {
+            ring.drain([&](const char* record, size_t length) {
+                WireHeader header;
+                std::memcpy(&header, record, sizeof(header));
+                Envelope* envelope = EnvelopePool::instance().acquire(allocations);
+                envelope->from_id = header.from_id;
+                envelope->to_id = header.to_id;
+                envelope->content.assign(record + sizeof(header), length - sizeof(header));
+                envelope->delivery_time = at_ms(header.delivery_ms);
+                pending.push_back({header.delivery_ms, header.from_id, header.to_id, header.seq, envelope});
+            });
+        }
+    }
+
+    // Everything due before window_end has arrived by now; schedule it in a
+    // fixed order so the interleaving never depends on process timing
+    void schedule_pending(int64_t window_end_ms) {
+        auto due_end = std::partition(pending.begin(), pending.end(),
+                                      [&](const PendingMessage& msg) { return msg.delivery_ms < window_end_ms; });
+        std::sort(pending.begin(), due_end, [](const PendingMessage& a, const PendingMessage& b) {
+            if (a.delivery_ms != b.delivery_ms) return a.delivery_ms < b.delivery_ms;
+            if (a.from_id != b.from_id) return a.from_id < b.from_id;
+            return a.seq < b.seq;
+        });
+        for (auto it = pending.begin(); it != due_end; ++it) {
+            Envelope* envelope = it->envelope;
+            scheduler->schedule_at(envelope->delivery_time, [this, envelope]() { deliver(envelope); });
+        }
+        pending.erase(pending.begin(), due_end);
+    }
+
+    void barrier() {
+        uint32_t generation = control->generation.load(std::memory_order_acquire);
+        if (control->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 ==
+            static_cast<uint32_t>(config.num_shards)) {
+            control->arrived.store(0, std::memory_order_relaxed);
+            control->generation.fetch_add(1, std::memory_order_release);
+            return;
+        }
+        while (control->generation.load(std::memory_order_acquire) == generation) {
+            drain_incoming();  // Keeps senders that are blocked on a full ring moving
+            std::this_thread::yield();
+        }
+    }
+
+    void poll_detections() {
+        int64_t now = now_ms();
+        for (size_t i = 0; i < crashed.size(); ++i) {
+            if (first_detection_ms[i] >= 0) {
+                continue;
+            }
+            for (NodeId observer : observers) {
+                if (local_nodes[observer]->is_node_failed(crashed[i])) {
+                    first_detection_ms[i] = now;
+                    break;
+                }
+            }
+        }
+    }
+
+public:
+    ShardProcess(const ShardedSimulator::Config& sim_config, int shard_index, char* shared,
+                 const std::vector<NodeId>& ids, const std::vector<NodeId>& crashed_ids)
+        : config(sim_config), shard(shard_index), crashed(crashed_ids),
+          scheduler(std::make_shared<EventScheduler>()) {
+        size_t shards = static_cast<size_t>(config.num_shards);
+        size_t failures = crashed.size();
+        control = reinterpret_cast<SharedControl*>(shared);
+        char* cursor = shared + align64(sizeof(SharedControl));
+        report = reinterpret_cast<ShardReport*>(cursor) + shard;
+        cursor += align64(shards * sizeof(ShardReport));
+        first_detection_ms = reinterpret_cast<int64_t*>(cursor) + shard * failures;
+        cursor += align64(shards * failures * sizeof(int64_t));
+        size_t ring_stride = ShmRing::bytes_needed(config.ring_bytes);
+        for (size_t other = 0; other < shards; ++other) {
+            outgoing.emplace_back(cursor + (shard * shards + other) * ring_stride, config.ring_bytes, false);
+            incoming.emplace_back(cursor + (other * shards + shard) * ring_stride, config.ring_bytes, false);
+        }
+
+        NodeId max_id = *std::max_element(ids.begin(), ids.end());
+        shard_of.assign(static_cast<size_t>(max_id) + 1, -1);
+        send_seq.assign(shard_of.size(), 0);
+        local_nodes.resize(shard_of.size());
+        is_crashed.assign(shard_of.size(), false);
+        for (NodeId id : crashed) {
+            is_crashed[id] = true;
+        }
+
+        std::vector<std::string> names;
+        for (size_t i = 0; i < ids.size(); ++i) {
+            shard_of[ids[i]] = static_cast<int>(i % shards);
+            names.push_back(node_name(static_cast<int>(i)));
+        }
+        for (size_t i = shard; i < ids.size(); i += shards) {
+            std::vector<std::string> peers;
+            for (size_t j = 0; j < ids.size(); ++j) {
+                if (j != i) {
+                    peers.push_back(names[j]);
+                }
+            }
+            auto node = std::make_shared<GossipNode>(names[i], peers, scheduler);
+            node->set_seed(splitmix64(config.seed ^ (uint64_t{ids[i]} << 32)));
+            node->attach_transport(this);
+            local_nodes[ids[i]] = node;
+            if (!is_crashed[ids[i]]) {
+                observers.push_back(ids[i]);
+            }
+        }
+    }
+
+    void send_message(NodeId from_id, NodeId to_id, const std::string& content,
+                      size_t /*full_state_bytes*/) override {
+        report->messages_sent++;
+        uint64_t seq = send_seq[from_id]++;
+        uint64_t bits = splitmix64(config.seed ^ (uint64_t{from_id} << 40) ^ seq);
+        if (unit(bits) < message_loss_rate || to_id >= shard_of.size() || shard_of[to_id] < 0) {
+            report->dropped_messages++;
+            return;
+        }
+        // Box-Muller on two more draws from the same stream
+        double u1 = std::max(unit(splitmix64(bits)), 1e-12);
+        double u2 = unit(splitmix64(bits ^ 0x5851f42d4c957f2dULL));
+        double normal = std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+        int64_t delay = std::max<int64_t>(config.min_link_delay_ms,
+                                          static_cast<int64_t>(mean_delay + std_dev_delay * normal));
+        int64_t delivery_ms = now_ms() + delay;
+
+        int destination = shard_of[to_id];
+        if (destination == shard) {
+            uint64_t allocations = 0;
+            Envelope* envelope = EnvelopePool::instance().acquire(allocations);
+            envelope->from_id = from_id;
+            envelope->to_id = to_id;
+            envelope->content.assign(content);
+            envelope->delivery_time = at_ms(delivery_ms);
+            scheduler->schedule_at(envelope->delivery_time, [this, envelope]() { deliver(envelope); });
+            return;
+        }
+
+        report->cross_shard_messages++;
+        WireHeader header{from_id, to_id, delivery_ms, seq};
+        while (!outgoing[destination].try_push(&header, sizeof(header), content.data(), content.size())) {
+            drain_incoming();  // Whoever we are waiting on may be waiting on us
+            std::this_thread::yield();
+        }
+    }
+
+    void run() {
+        for (auto& entry : local_nodes) {
+            if (entry) {
+                entry->start();
+            }
+        }
+        for (NodeId id : crashed) {
+            if (local_nodes[id]) {
+                auto node = local_nodes[id];
+                scheduler->schedule_at(at_ms(config.crash_at_ms), [node]() { node->set_alive(false); });
+            }
+        }
+
+        const int64_t window = std::max(1, config.min_link_delay_ms);
+        int windows = 0;
+        for (int64_t start = 0; start < config.duration_ms; start += window) {
+            int64_t end = start + window;
+            schedule_pending(end);
+            // Half-open window: events at exactly end belong to the next one
+            scheduler->run_until(at_ms(end) - TaskScheduler::TimePoint::duration(1));
+            if (end > config.crash_at_ms) {
+                poll_detections();
+            }
+            barrier();
+            drain_incoming();
+            windows++;
+        }
+
+        int detected = 0, expected = 0, false_positives = 0;
+        for (NodeId observer : observers) {
+            auto& node = local_nodes[observer];
+            for (NodeId failed : node->get_failed_node_ids()) {
+                if (failed < is_crashed.size() && is_crashed[failed]) {
+                    detected++;
+                } else {
+                    false_positives++;
+                }
+            }
+            expected += static_cast<int>(crashed.size());
+        }
+        report->detected_pairs = detected;
+        report->expected_pairs = expected;
+        report->false_positive_pairs = false_positives;
+        report->windows = windows;
+    }
+};
+
+}  // namespace
+
+ShardedSimulator::ShardedSimulator(const Config& sim_config) : config(sim_config) {}
+
+ShardedSimulator::Result ShardedSimulator::run() {
+    Result result{};
+    auto wall_start = std::chrono::steady_clock::now();
+    size_t shards = static_cast<size_t>(std::max(1, config.num_shards));
+    config.num_shards = static_cast<int>(shards);
+
+    // Intern every name before forking so all shards agree on NodeIds
+    std::vector<NodeId> ids;
+    for (int i = 0; i < config.num_nodes; ++i) {
+        ids.push_back(NodeRegistry::instance().intern(node_name(i)));
+    }
+    std::vector<NodeId> crashed = ids;
+    std::mt19937 rng(static_cast<std::mt19937::result_type>(config.seed));
+    std::shuffle(crashed.begin(), crashed.end(), rng);
+    crashed.resize(std::min<size_t>(std::max(0, config.num_failures), crashed.size()));
+
+    size_t failures = crashed.size();
+    size_t ring_stride = ShmRing::bytes_needed(config.ring_bytes);
+    size_t header_bytes = align64(sizeof(SharedControl)) + align64(shards * sizeof(ShardReport)) +
+                          align64(shards * failures * sizeof(int64_t));
+    size_t total_bytes = header_bytes + shards * shards * ring_stride;
+    void* mapping = mmap(nullptr, total_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        return result;
+    }
+    char* shared = static_cast<char*>(mapping);
+    auto* control = new (shared) SharedControl();
+    control->arrived.store(0);
+    control->generation.store(0);
+    auto* reports = reinterpret_cast<ShardReport*>(shared + align64(sizeof(SharedControl)));
+    std::fill(reports, reports + shards, ShardReport{});
+    auto* detections = reinterpret_cast<int64_t*>(shared + align64(sizeof(SharedControl)) +
+                                                  align64(shards * sizeof(ShardReport)));
+    std::fill(detections, detections + shards * failures, int64_t{-1});
+    for (size_t i = 0; i < shards * shards; ++i) {
+        ShmRing(shared + header_bytes + i * ring_stride, config.ring_bytes, true);
+    }
+
+    std::vector<pid_t> children;
+    for (size_t shard = 0; shard < shards; ++shard) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            {
+                ShardProcess process(config, static_cast<int>(shard), shared, ids, crashed);
+                process.run();
+            }
+            _exit(0);  // Skip the parent's atexit handlers and static destructors
+        }
+        if (pid < 0) {
+            break;  // The shards that did start will wait at the first barrier forever
+        }
+        children.push_back(pid);
+    }
+
+    result.ok = children.size() == shards;
+    if (!result.ok) {
+        for (pid_t pid : children) {
+            kill(pid, SIGKILL);
+        }
+    }
+    for (pid_t pid : children) {
+        int status = 0;
+        if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            result.ok = false;
+        }
+    }
+
+    if (result.ok) {
+        for (size_t shard = 0; shard < shards; ++shard) {
+            const ShardReport& report = reports[shard];
+            result.windows = report.windows;
+            result.messages_sent += report.messages_sent;
+            result.cross_shard_messages += report.cross_shard_messages;
+            result.dropped_messages += report.dropped_messages;
+            result.detected_pairs += report.detected_pairs;
+            result.expected_pairs += report.expected_pairs;
+            result.false_positive_pairs += report.false_positive_pairs;
+        }
+        // The first detection of each crashed node anywhere in the cluster
+        double total_ms = 0;
+        int detected_nodes = 0;
+        for (size_t i = 0; i < failures; ++i) {
+            int64_t first = -1;
+            for (size_t shard = 0; shard < shards; ++shard) {
+                int64_t at = detections[shard * failures + i];
+                if (at >= 0 && (first < 0 || at < first)) {
+                    first = at;
+                }
+            }
+            if (first >= 0) {
+                total_ms += static_cast<double>(first - config.crash_at_ms);
+                detected_nodes++;
+            }
+        }
+        result.detection_time_ms = detected_nodes > 0 ? total_ms / detected_nodes : -1.0;
+    }
+    munmap(mapping, total_bytes);
+
+    result.wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall_start).count();
+    return result;
+}
+
+void ShardedSimulator::print(const Config& config, const Result& result) {
+    std::cout << "Sharded gossip simulation (" << config.num_nodes << " nodes, "
+              << config.num_shards << " processes)\n";
+    if (!result.ok) {
+        std::cout << "A shard process failed\n";
+        return;
+    }
+    std::cout << "Windows: " << result.windows << " x " << config.min_link_delay_ms << "ms\n"
+              << "Messages Sent: " << result.messages_sent
+              << " (cross-shard " << result.cross_shard_messages
+              << ", dropped " << result.dropped_messages << ")\n"
+              << "Detected: " << result.detected_pairs << "/" << result.expected_pairs << " observer pairs\n"
+              << "False Positive Pairs: " << result.false_positive_pairs << "\n"
+              << "Detection Time: " << result.detection_time_ms << "ms\n"
+              << "Wall Time: " << result.wall_ms << "ms\n";
+}
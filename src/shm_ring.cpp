@@ -0,0 +1,59 @@
+#include "shm_ring.hpp"
+#include <cstring>
+#include <new>
+
+namespace {
+
+size_t round_up_pow2(size_t value) {
+    size_t result = 64;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+}  // namespace
+
+size_t ShmRing::bytes_needed(size_t capacity) {
+    return sizeof(Control) + round_up_pow2(capacity);
+}
+
+ShmRing::ShmRing(void* memory, size_t ring_capacity, bool initialize)
+    : control(static_cast<Control*>(memory)),
+      data(static_cast<char*>(memory) + sizeof(Control)),
+      capacity(round_up_pow2(ring_capacity)) {
+    if (initialize) {
+        new (control) Control();
+        control->head.store(0, std::memory_order_relaxed);
+        control->tail.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool ShmRing::try_push(const void* header, size_t header_length, const void* payload, size_t payload_length) {
+    size_t length = header_length + payload_length;
+    size_t needed = record_size(length);
+    uint64_t tail = control->tail.load(std::memory_order_relaxed);
+    uint64_t head = control->head.load(std::memory_order_acquire);
+
+    size_t position = tail & (capacity - 1);
+    size_t to_end = capacity - position;
+    size_t padding = (to_end < needed) ? to_end : 0;  // Records never straddle the end
+    if (needed + padding > capacity - (tail - head)) {
+        return false;
+    }
+
+    if (padding > 0) {
+        uint32_t marker = wrap_marker;
+        std::memcpy(data + position, &marker, sizeof(marker));
+        tail += padding;
+        position = 0;
+    }
+    uint32_t stored_length = static_cast<uint32_t>(length);
+    std::memcpy(data + position, &stored_length, sizeof(stored_length));
+    std::memcpy(data + position + 4, header, header_length);
+    if (payload_length > 0) {
+        std::memcpy(data + position + 4 + header_length, payload, payload_length);
+    }
+    control->tail.store(tail + needed, std::memory_order_release);
+    return true;
+}
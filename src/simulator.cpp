@@ -1,12 +1,109 @@
 #include "simulator.hpp"
+#include "scenario_script.hpp"
 #include <iostream>
 #include <algorithm>
+#include <cmath>
+#include <sstream>
 #include <thread>
 #include <chrono>
 #include <random>
 #include <unordered_set>
 
-Simulator::Simulator() {}
+Simulator::Simulator(ExecutionMode execution_mode, size_t pool_threads)
+    : mode(execution_mode),
+      virtual_clock(mode == ExecutionMode::VirtualTime ? std::make_shared<EventScheduler>() : nullptr),
+      worker_pool(mode == ExecutionMode::SharedPool ? std::make_shared<WorkerPool>(pool_threads) : nullptr),
+      scheduler(virtual_clock ? std::shared_ptr<TaskScheduler>(virtual_clock)
+                              : std::shared_ptr<TaskScheduler>(worker_pool)),
+      network(scheduler),
+      run_seed(0),
+      view_observers({&oracle, &convergence}) {
+    std::random_device device;
+    set_seed((uint64_t{device()} << 32) | device());
+}
+
+Simulator::~Simulator() {
+    cleanup_network();
+    stop_trace();
+    // Pool tasks may still reference the network, so stop them before it goes away
+    if (worker_pool) {
+        worker_pool->shutdown();
+    }
+}
+
+void Simulator::advance_time(int duration_ms) {
+    if (virtual_clock) {
+        virtual_clock->run_for(duration_ms);
+    } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+    }
+}
+
+void Simulator::set_seed(uint64_t seed) {
+    run_seed = seed;
+    // Both halves, so seeds that differ only in the high bits still pick different nodes
+    std::seed_seq sequence{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+    rng.seed(sequence);
+    network.set_seed(node_seed(~size_t{0}));
+}
+
+uint64_t Simulator::node_seed(size_t index) const {
+    // splitmix64 of (seed, index): neighbouring indices get unrelated streams
+    uint64_t x = run_seed + 0x9e3779b97f4a7c15ULL * (static_cast<uint64_t>(index) + 1);
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+bool Simulator::start_trace(const std::string& path) {
+    stop_trace();
+    auto recorder = std::make_unique<TraceRecorder>();
+    if (!recorder->open(path, run_seed)) {
+        return false;
+    }
+    trace = std::move(recorder);
+    network.set_trace(trace.get());
+    return true;
+}
+
+void Simulator::stop_trace() {
+    if (trace) {
+        network.set_trace(nullptr);
+        trace->close();
+        trace.reset();
+    }
+}
+
+void Simulator::record_injection(TraceEvent type, const std::string& node_id) {
+    if (trace) {
+        trace->record(type, current_time_ms(), NodeRegistry::instance().find(node_id));
+    }
+}
+
+int Simulator::random_index(int low, int high) {
+    return std::uniform_int_distribution<int>(low, high)(rng);
+}
+
+int Simulator::monitor_count(int num_nodes) const {
+    return std::max(1, std::min(heartbeat_monitors, num_nodes - 1));
+}
+
+void Simulator::set_heartbeat_monitors(int monitors, int replicas) {
+    heartbeat_monitors = std::max(1, monitors);
+    heartbeat_replicas = std::max(1, replicas);
+}
+
+std::chrono::system_clock::time_point Simulator::current_time() const {
+    return scheduler ? scheduler->now() : std::chrono::system_clock::now();
+}
+
+int64_t Simulator::current_time_ms() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(current_time().time_since_epoch()).count();
+}
+
+long long Simulator::elapsed_ms(std::chrono::system_clock::time_point since) const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(current_time() - since).count();
+}
 
 void Simulator::setup_gossip_network(int num_nodes) {
     cleanup_network();
@@ -16,14 +113,29 @@ void Simulator::setup_gossip_network(int num_nodes) {
         node_ids.push_back("node" + std::to_string(i));
     }
     
-    for (const auto& id : node_ids) {
-        auto node = std::make_shared<GossipNode>(id, node_ids);
+    for (size_t i = 0; i < node_ids.size(); ++i) {
+        const auto& id = node_ids[i];
+        auto node = std::make_shared<GossipNode>(id, node_ids, scheduler);
+        node->set_seed(node_seed(i));
+        node->set_timing(detector_params.gossip_interval_ms, detector_params.suspicion_threshold,
+                         detector_params.fanout);
+        node->set_delta_gossip(delta_gossip);
+        node->set_coalescing(coalescing);
+        node->set_anti_entropy(anti_entropy);
+        node->set_peer_sampling(peer_sampling);
+        if (zones > 1) {
+            auto& registry = NodeRegistry::instance();
+            for (size_t j = 0; j < node_ids.size(); ++j) {
+                node->set_zone(registry.intern(node_ids[j]), static_cast<int>(j % zones));
+            }
+        }
         network.add_node(id, node);
         node->start();
     }
+    register_members(node_ids, num_nodes);
 }
 
-void Simulator::setup_heartbeat_network(int num_nodes) {
+void Simulator::setup_heartbeat_network(int num_nodes, double phi_threshold) {
     cleanup_network();
     
     std::vector<std::string> node_ids;
@@ -31,41 +143,113 @@ void Simulator::setup_heartbeat_network(int num_nodes) {
         node_ids.push_back("node" + std::to_string(i));
     }
     
-    for (const auto& id : node_ids) {
-        auto node = std::make_shared<HeartbeatNode>(id, id == "node0");  // First node is master
+    // The first heartbeat_monitors nodes are masters; with more than one, workers are sharded over a ring
+    std::shared_ptr<HashRing> ring;
+    int monitors = monitor_count(num_nodes);
+    if (monitors > 1) {
+        ring = std::make_shared<HashRing>();
+        for (int i = 0; i < monitors; ++i) {
+            ring->add(NodeRegistry::instance().intern(node_ids[i]));
+        }
+    }
+    
+    for (int i = 0; i < num_nodes; ++i) {
+        const auto& id = node_ids[i];
+        auto node = std::make_shared<HeartbeatNode>(id, i < monitors, scheduler);  // Masters come first
+        node->set_master("node0");
+        node->set_timing(detector_params.heartbeat_interval_ms, detector_params.failure_threshold_ms);
+        node->set_coalescing(coalescing);
+        if (ring) {
+            node->set_monitor_ring(ring, heartbeat_replicas);
+        }
+        if (phi_threshold > 0) {
+            node->set_detection_mode(HeartbeatNode::DetectionMode::PhiAccrual);
+            node->set_phi_threshold(phi_threshold);
+        }
         network.add_node(id, node);
         node->start();
     }
+    register_members(node_ids, monitors);
+}
+
+void Simulator::setup_swim_network(int num_nodes) {
+    cleanup_network();
+    
+    std::vector<std::string> node_ids;
+    for (int i = 0; i < num_nodes; ++i) {
+        node_ids.push_back("node" + std::to_string(i));
+    }
+    
+    for (size_t i = 0; i < node_ids.size(); ++i) {
+        const auto& id = node_ids[i];
+        auto node = std::make_shared<SwimNode>(id, node_ids, scheduler);
+        node->set_seed(node_seed(i));
+        node->set_coalescing(coalescing);
+        network.add_node(id, node);
+        node->start();
+    }
+    register_members(node_ids, num_nodes);
+}
+
+void Simulator::register_members(const std::vector<std::string>& node_ids, int observers) {
+    active_node_ids = node_ids;
+    active_numeric_ids.clear();
+    int64_t now_ms = current_time_ms();
+    oracle.reset();
+    convergence.reset(now_ms);
+    for (size_t i = 0; i < node_ids.size(); ++i) {
+        NodeId id = NodeRegistry::instance().find(node_ids[i]);
+        bool observer = static_cast<int>(i) < observers;
+        active_numeric_ids.push_back(id);
+        oracle.add_member(id, observer, now_ms);
+        convergence.add_member(id, observer, now_ms);
+        network.get_node(id)->attach_observer(&view_observers);
+    }
+}
+
+void Simulator::setup_network(Algorithm algorithm, int num_nodes) {
+    switch (algorithm) {
+        case Algorithm::Gossip:
+            setup_gossip_network(num_nodes);
+            break;
+        case Algorithm::Heartbeat:
+            setup_heartbeat_network(num_nodes);
+            break;
+        case Algorithm::Swim:
+            setup_swim_network(num_nodes);
+            break;
+    }
 }
 
 void Simulator::cleanup_network() {
     // Stop all nodes first
-    for (int i = 0; i < 100; ++i) {  // Assuming max 100 nodes
-        std::string id = "node" + std::to_string(i);
+    for (const auto& id : active_node_ids) {
         auto node = network.get_node(id);
         if (node) {
             node->stop();
+            node->attach_observer(nullptr);
         }
     }
     
     // Then remove them from the network
-    for (int i = 0; i < 100; ++i) {
-        std::string id = "node" + std::to_string(i);
+    for (const auto& id : active_node_ids) {
         network.remove_node(id);
     }
+    network.discard_in_flight();
+    network.heal_network_partition();
+    active_node_ids.clear();
+    active_numeric_ids.clear();
 }
 
-Simulator::TestResult Simulator::run_single_node_failure_test(int num_nodes) {
+Simulator::TestResult Simulator::run_single_node_failure_test(int num_nodes, Algorithm algorithm) {
     cleanup_network();  // Ensure clean state
-    setup_gossip_network(num_nodes);
+    setup_network(algorithm, num_nodes);
     
     // Generate some initial traffic
-    for (int i = 0; i < num_nodes; ++i) {
-        for (int j = 0; j < num_nodes; ++j) {
-            if (i != j) {
-                network.send_message("node" + std::to_string(i),
-                                   "node" + std::to_string(j),
-                                   "initial_traffic");
+    for (NodeId from : active_numeric_ids) {
+        for (NodeId to : active_numeric_ids) {
+            if (from != to) {
+                network.send_message(from, to, "initial_traffic");
             }
         }
     }
@@ -73,53 +257,29 @@ Simulator::TestResult Simulator::run_single_node_failure_test(int num_nodes) {
     // Process initial messages
     for (int i = 0; i < 50; ++i) {  // Process messages for 5 seconds
         network.process_messages();
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        advance_time(100);
     }
     
-    // Reset network stats before failure simulation
-    network.reset_stats();
-    
-    // Choose a random node to fail
-    std::string failed_node = "node" + std::to_string(rand() % num_nodes);
+    begin_measurement();
     
-    // Record start time
-    auto start_time = std::chrono::steady_clock::now();
+    // Choose a random node to fail (only the masters watch in the heartbeat network, so never one of them)
+    int first_candidate = algorithm == Algorithm::Heartbeat ? monitor_count(num_nodes) : 0;
+    std::string failed_node = active_node_ids[random_index(first_candidate, num_nodes - 1)];
     
     // Simulate node failure
     simulate_failures({failed_node});
     
-    // Process messages and wait for failure detection
-    bool failure_detected = false;
-    int detection_time_ms = 5000;  // Default to timeout
+    // Run until every live observer suspects the failed node, or time out
+    wait_for_detection(5000);
     
-    while (std::chrono::duration_cast<std::chrono::milliseconds>(
-               std::chrono::steady_clock::now() - start_time).count() < 5000) {
-        network.process_messages();
-        
-        // Check if failure is detected
-        for (int i = 0; i < num_nodes; ++i) {
-            std::string node_id = "node" + std::to_string(i);
-            if (node_id != failed_node) {
-                auto node = std::dynamic_pointer_cast<GossipNode>(network.get_node(node_id));
-                if (node) {
-                    auto failed_nodes = node->get_failed_nodes();
-                    if (std::find(failed_nodes.begin(), failed_nodes.end(), failed_node) != failed_nodes.end()) {
-                        failure_detected = true;
-                        detection_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                            std::chrono::steady_clock::now() - start_time).count();
-                        break;
-                    }
-                }
-            }
-        }
-        
-        if (failure_detected) break;
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    static const char* algorithm_names[] = {"Gossip", "Heartbeat", "SWIM"};
+    auto result = collect_metrics(std::string("Single Node Failure Test (") +
+                                  algorithm_names[static_cast<int>(algorithm)] + ")");
+    auto detections = oracle.get_detections();
+    if (detections.empty() || detections.back().latencies_ms.empty()) {
+        result.detection_time_ms = 5000;  // Nobody noticed within the window
     }
     
-    auto result = collect_metrics("Single Node Failure Test");
-    result.detection_time_ms = detection_time_ms;
-    
     // Clean up
     cleanup_network();
     
@@ -129,19 +289,18 @@ Simulator::TestResult Simulator::run_single_node_failure_test(int num_nodes) {
 Simulator::TestResult Simulator::run_multiple_failures_test(int num_nodes, int num_failures) {
     setup_gossip_network(num_nodes);
     wait_for_convergence(5000);
+    begin_measurement();
     
     // Choose random nodes to fail
-    std::vector<std::string> failed_nodes;
-    for (int i = 0; i < num_failures; ++i) {
-        failed_nodes.push_back("node" + std::to_string(i));
-    }
-    std::random_shuffle(failed_nodes.begin(), failed_nodes.end());
+    std::vector<std::string> failed_nodes = active_node_ids;
+    std::shuffle(failed_nodes.begin(), failed_nodes.end(), rng);
+    failed_nodes.resize(std::min<size_t>(failed_nodes.size(), std::max(0, num_failures)));
     
     // Simulate failures
     simulate_failures(failed_nodes);
     
     // Wait for failure detection
-    wait_for_convergence(5000);
+    wait_for_detection(5000);
     
     return collect_metrics("Multiple Failures Test");
 }
@@ -149,25 +308,28 @@ Simulator::TestResult Simulator::run_multiple_failures_test(int num_nodes, int n
 Simulator::TestResult Simulator::run_network_partition_test(int num_nodes) {
     setup_gossip_network(num_nodes);
     wait_for_convergence(5000);
+    begin_measurement();
     
     // Split nodes into two partitions
     std::vector<std::string> partition1, partition2;
     for (int i = 0; i < num_nodes; ++i) {
         if (i < num_nodes / 2) {
-            partition1.push_back("node" + std::to_string(i));
+            partition1.push_back(active_node_ids[i]);
         } else {
-            partition2.push_back("node" + std::to_string(i));
+            partition2.push_back(active_node_ids[i]);
         }
     }
     
-    // Simulate network partition
+    // Simulate network partition; now that sends honour it, each side comes to suspect the other
     network.simulate_network_partition(partition1, partition2, 5000);
+    for (int elapsed = 0; elapsed < 5000; elapsed += 100) {
+        network.process_messages();
+        advance_time(100);
+    }
     
-    // Wait for failure detection
-    wait_for_convergence(5000);
-    
-    // Heal partition
+    // Heal partition and let the views merge again
     network.heal_network_partition();
+    wait_for_convergence(5000);
     
     return collect_metrics("Network Partition Test");
 }
@@ -175,20 +337,25 @@ Simulator::TestResult Simulator::run_network_partition_test(int num_nodes) {
 Simulator::TestResult Simulator::run_high_load_test(int num_nodes) {
     setup_gossip_network(num_nodes);
     wait_for_convergence(5000);
-    
-    // Generate high message load
-    for (int i = 0; i < num_nodes; ++i) {
-        for (int j = 0; j < num_nodes; ++j) {
-            if (i != j) {
-                network.send_message("node" + std::to_string(i),
-                                   "node" + std::to_string(j),
-                                   "high_load_test");
+    begin_measurement();
+    
+    // Generate high message load through the nodes themselves: a coalescing node
+    // queues its burst and its next tick flushes it together with its own gossip
+    for (NodeId from : active_numeric_ids) {
+        auto node = network.get_node(from);
+        if (!node) {
+            continue;
+        }
+        std::string from_id = node->get_id();
+        for (const auto& to : active_node_ids) {
+            if (to != from_id) {
+                node->send_message(to, "high_load_test");
             }
         }
     }
     
     // Wait for message processing
-    std::this_thread::sleep_for(std::chrono::seconds(5));
+    advance_time(5000);
     
     return collect_metrics("High Load Test");
 }
@@ -196,13 +363,14 @@ Simulator::TestResult Simulator::run_high_load_test(int num_nodes) {
 Simulator::TestResult Simulator::run_recovery_test(int num_nodes) {
     setup_gossip_network(num_nodes);
     wait_for_convergence(5000);
+    begin_measurement();
     
     // Choose a random node to fail and recover
-    std::string node_id = "node" + std::to_string(rand() % num_nodes);
+    std::string node_id = active_node_ids[random_index(0, num_nodes - 1)];
     
     // Simulate failure and recovery
     simulate_failures({node_id});
-    std::this_thread::sleep_for(std::chrono::seconds(2));
+    advance_time(2000);
     simulate_recoveries({node_id});
     
     // Wait for recovery detection
@@ -211,18 +379,106 @@ Simulator::TestResult Simulator::run_recovery_test(int num_nodes) {
     return collect_metrics("Recovery Test");
 }
 
+Simulator::TestResult Simulator::run_scenario(const ScenarioScript& script) {
+    DetectorParams saved_params = detector_params;
+    detector_params = script.params;
+    bool custom_links = script.has_network || !script.topology_path.empty();
+    if (custom_links) {
+        network.clear_topology();
+        if (script.has_network) {
+            network.set_default_link(script.network);
+        }
+        std::string error;
+        if (!script.topology_path.empty() && !network.load_topology(script.topology_path, error)) {
+            std::cerr << "Scenario topology: " << error << "\n";
+        }
+    }
+    
+    setup_network(script.algorithm, script.num_nodes);
+    for (int elapsed = 0; elapsed < script.warmup_ms; elapsed += 100) {
+        network.process_messages();
+        advance_time(100);
+    }
+    begin_measurement();
+    
+    // Heartbeat monitors are the only observers, so random crashes spare them
+    int first_candidate = script.algorithm == Algorithm::Heartbeat ? monitor_count(script.num_nodes) : 0;
+    std::vector<std::string> crashed;
+    for (const auto& step : script.steps) {
+        switch (step.action) {
+            case ScenarioScript::Action::Crash: {
+                std::vector<std::string> targets = step.nodes;
+                if (targets.empty()) {
+                    std::vector<std::string> live;
+                    for (int i = first_candidate; i < script.num_nodes; ++i) {
+                        if (std::find(crashed.begin(), crashed.end(), active_node_ids[i]) == crashed.end()) {
+                            live.push_back(active_node_ids[i]);
+                        }
+                    }
+                    std::shuffle(live.begin(), live.end(), rng);
+                    live.resize(std::min<size_t>(live.size(), step.count));
+                    targets = live;
+                }
+                simulate_failures(targets);
+                crashed.insert(crashed.end(), targets.begin(), targets.end());
+                break;
+            }
+            case ScenarioScript::Action::Recover: {
+                std::vector<std::string> targets = step.all ? crashed : step.nodes;
+                simulate_recoveries(targets);
+                for (const auto& id : targets) {
+                    crashed.erase(std::remove(crashed.begin(), crashed.end(), id), crashed.end());
+                }
+                break;
+            }
+            case ScenarioScript::Action::Partition: {
+                if (step.all) {
+                    auto middle = active_node_ids.begin() + script.num_nodes / 2;
+                    network.simulate_network_partition({active_node_ids.begin(), middle},
+                                                       {middle, active_node_ids.end()}, 0);
+                } else {
+                    network.simulate_network_partition(step.nodes, step.other, 0);
+                }
+                break;
+            }
+            case ScenarioScript::Action::Heal:
+                network.heal_network_partition();
+                break;
+            case ScenarioScript::Action::Wait:
+                for (int elapsed = 0; elapsed < step.count; elapsed += 100) {
+                    network.process_messages();
+                    advance_time(100);
+                }
+                break;
+            case ScenarioScript::Action::WaitDetection:
+                wait_for_detection(step.count);
+                break;
+            case ScenarioScript::Action::WaitConvergence:
+                wait_for_convergence(step.count);
+                break;
+        }
+    }
+    
+    auto result = collect_metrics(script.name);
+    cleanup_network();
+    if (custom_links) {
+        network.clear_topology();
+    }
+    detector_params = saved_params;
+    return result;
+}
+
 std::vector<Simulator::TestResult> Simulator::compare_algorithms(int num_nodes) {
     std::vector<TestResult> results;
     
     // Test Gossip-based detection
-    setup_gossip_network(num_nodes);
-    results.push_back(run_single_node_failure_test(num_nodes));
-    cleanup_network();
+    results.push_back(run_single_node_failure_test(num_nodes, Algorithm::Gossip));
     
     // Test Heartbeat-based detection
-    setup_heartbeat_network(num_nodes);
-    results.push_back(run_single_node_failure_test(num_nodes));
-    cleanup_network();
+    results.push_back(run_single_node_failure_test(num_nodes, Algorithm::Heartbeat));
+    
+    // Test SWIM probe-based detection
+    results.push_back(run_single_node_failure_test(num_nodes, Algorithm::Swim));
     
     return results;
 }
@@ -239,51 +495,146 @@ void Simulator::run_all_tests(int num_nodes) {
     // Print results
     for (const auto& result : results) {
         std::cout << "Test: " << result.test_name << "\n"
-                  << "Detection Time: " << result.detection_time_ms << "ms\n"
-                  << "False Positives: " << result.false_positives << "\n"
+                  << "Detection Time (first/median/last): " << format_ms(result.detection_time_ms) << "/"
+                  << format_ms(result.median_detection_ms) << "/" << format_ms(result.last_detection_ms) << "\n"
+                  << "False Positives: " << result.false_positives << " (" << result.mistake_rate
+                  << "/pair/s, lasting " << result.mean_mistake_ms << "ms, recurring every "
+                  << result.mean_recurrence_ms << "ms)\n"
                   << "False Negatives: " << result.false_negatives << "\n"
                   << "Messages Sent: " << result.messages_sent << "\n"
+                  << "Bytes Sent: " << result.bytes_sent << " (saved " << result.bytes_saved << ")\n"
+                  << "Allocations/Message: " << result.allocations_per_message << "\n"
+                  << "Delivery p99/p999: " << result.delivery_p99_ms << "/" << result.delivery_p999_ms << "ms\n"
+                  << "Queueing p99: " << result.queueing_p99_ms << "ms\n"
                   << "Accuracy: " << result.accuracy << "\n\n";
     }
 }
 
+std::vector<Simulator::TestResult> Simulator::compare_peer_sampling(int num_nodes) {
+    static const std::pair<PeerSampler::Strategy, const char*> strategies[] = {
+        {PeerSampler::Strategy::Random, "random"},
+        {PeerSampler::Strategy::RoundRobin, "round-robin"},
+        {PeerSampler::Strategy::ZoneAware, "zone-aware"},
+    };
+    auto configured = peer_sampling;
+    std::vector<TestResult> results;
+    for (const auto& strategy : strategies) {
+        peer_sampling = strategy.first;
+        setup_gossip_network(num_nodes);
+        for (int elapsed = 0; elapsed < 5000; elapsed += 100) {  // Every counter has spread by now
+            network.process_messages();
+            advance_time(100);
+        }
+        begin_measurement();
+        
+        // Unlike the single-failure scenario, wait long enough for the slowest observer
+        simulate_failures({active_node_ids[random_index(0, num_nodes - 1)]});
+        wait_for_detection(30000);
+        results.push_back(collect_metrics(strategy.second));
+        cleanup_network();
+    }
+    peer_sampling = configured;
+    
+    for (const auto& result : results) {
+        std::cout << result.test_name << ": detection first/median/last " << format_ms(result.detection_time_ms) << "/"
+                  << format_ms(result.median_detection_ms) << "/" << format_ms(result.last_detection_ms)
+                  << ", missed " << result.false_negatives
+                  << ", false positives " << result.false_positives
+                  << ", accuracy " << result.accuracy << "\n";
+    }
+    return results;
+}
+
+std::vector<Simulator::PhiCurvePoint> Simulator::run_phi_threshold_sweep(int num_nodes,
+                                                                         const std::vector<double>& thresholds) {
+    std::vector<PhiCurvePoint> curve;
+    curve.push_back(measure_heartbeat_detection(num_nodes, 0.0));
+    for (double threshold : thresholds) {
+        curve.push_back(measure_heartbeat_detection(num_nodes, threshold));
+    }
+    
+    for (const auto& point : curve) {
+        std::cout << (point.phi_threshold > 0 ? "phi " + std::to_string(point.phi_threshold) : std::string("fixed timeout"))
+                  << ": detection " << point.detection_time_ms << "ms"
+                  << ", false positives " << point.false_positives
+                  << ", accuracy " << point.accuracy << "\n";
+    }
+    return curve;
+}
+
+Simulator::PhiCurvePoint Simulator::measure_heartbeat_detection(int num_nodes, double phi_threshold) {
+    const int warmup_ms = 10000;   // Lets the phi windows fill with real inter-arrival samples
+    const int window_ms = 10000;
+    
+    setup_heartbeat_network(num_nodes, phi_threshold);
+    for (int elapsed = 0; elapsed < warmup_ms; elapsed += 100) {
+        network.process_messages();
+        advance_time(100);
+    }
+    
+    begin_measurement();
+    
+    // The whole window runs even after the detection, so false suspicions of live workers count too
+    simulate_failures({active_node_ids[random_index(monitor_count(num_nodes), num_nodes - 1)]});
+    auto start_time = current_time();
+    while (elapsed_ms(start_time) < window_ms) {
+        network.process_messages();
+        advance_time(100);
+    }
+    
+    auto result = collect_metrics("Phi Threshold Sweep");
+    auto detections = oracle.get_detections();
+    bool detected = !detections.empty() && !detections.back().latencies_ms.empty();
+    PhiCurvePoint point{phi_threshold, detected ? result.detection_time_ms : static_cast<double>(window_ms),
+                        result.false_positives, result.accuracy};
+    
+    cleanup_network();
+    return point;
+}
+
 void Simulator::wait_for_convergence(int timeout_ms) {
-    auto start = std::chrono::steady_clock::now();
+    auto start = current_time();
     while (!check_convergence()) {
-        if (std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::steady_clock::now() - start).count() > timeout_ms) {
+        if (elapsed_ms(start) > timeout_ms) {
             break;
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        advance_time(100);
         network.process_messages();
     }
 }
 
-bool Simulator::check_convergence() {
-    // Simple convergence check: all nodes agree on the system state
-    std::unordered_set<std::string> failed_nodes;
-    bool first = true;
-    
-    for (int i = 0; i < 100; ++i) {  // Assuming max 100 nodes
-        std::string id = "node" + std::to_string(i);
-        auto node = std::dynamic_pointer_cast<GossipNode>(network.get_node(id));
-        if (!node) continue;
-        
-        auto current_failed = node->get_failed_nodes();
-        if (first) {
-            failed_nodes.insert(current_failed.begin(), current_failed.end());
-            first = false;
-        } else if (failed_nodes.size() != current_failed.size()) {
-            return false;
-        } else {
-            for (const auto& failed : current_failed) {
-                if (failed_nodes.find(failed) == failed_nodes.end()) {
-                    return false;
-                }
-            }
-        }
+void Simulator::wait_for_detection(int timeout_ms) {
+    auto start = current_time();
+    while (oracle.pending_detections() > 0 && elapsed_ms(start) < timeout_ms) {
+        network.process_messages();
+        advance_time(100);
     }
-    return true;
+    
+    // Otherwise the window closes on the tick of the last detection, and false
+    // suspicions raised in it would be scored as lasting 0 ms
+    for (int elapsed = 0; elapsed < suspicion_timeout_ms(); elapsed += 100) {
+        network.process_messages();
+        advance_time(100);
+    }
+}
+
+std::string Simulator::format_ms(double ms) {
+    if (std::isnan(ms)) {
+        return "n/a";
+    }
+    std::ostringstream text;
+    text << ms << "ms";
+    return text.str();
+}
+
+int Simulator::suspicion_timeout_ms() const {
+    return std::max(detector_params.gossip_interval_ms * detector_params.suspicion_threshold,
+                    detector_params.failure_threshold_ms);
+}
+
+bool Simulator::check_convergence() {
+    // Every node agrees on every member: nobody suspects it, or every live observer does
+    return convergence.is_converged();
 }
 
 void Simulator::simulate_failures(const std::vector<std::string>& node_ids) {
@@ -291,6 +642,9 @@ void Simulator::simulate_failures(const std::vector<std::string>& node_ids) {
         auto node = network.get_node(node_id);
         if (node) {
             node->set_alive(false);
+            oracle.record_crash(node->get_numeric_id(), current_time_ms());
+            convergence.record_crash(node->get_numeric_id(), current_time_ms());
+            record_injection(TraceEvent::Crash, node_id);
         }
     }
 }
@@ -300,33 +654,78 @@ void Simulator::simulate_recoveries(const std::vector<std::string>& node_ids) {
         auto node = network.get_node(node_id);
         if (node) {
             node->set_alive(true);
+            oracle.record_recovery(node->get_numeric_id(), current_time_ms());
+            convergence.record_recovery(node->get_numeric_id(), current_time_ms());
+            record_injection(TraceEvent::Recover, node_id);
         }
     }
 }
 
+void Simulator::print_latency_report(size_t worst_links) const {
+    auto stats = network.get_stats();
+    auto line = [](const char* label, const HdrHistogram& histogram) {
+        std::cout << "  " << label << ": n=" << histogram.get_count()
+                  << " p50=" << histogram.value_at_percentile(50.0) / 1000.0
+                  << " p99=" << histogram.value_at_percentile(99.0) / 1000.0
+                  << " p999=" << histogram.value_at_percentile(99.9) / 1000.0
+                  << " max=" << histogram.get_max() / 1000.0 << "ms\n";
+    };
+    for (size_t type = 0; type < Network::message_type_count; ++type) {
+        const auto& latency = stats.by_type[type];
+        if (latency.delivery_delay_us.get_count() == 0 && latency.processing_us.get_count() == 0) {
+            continue;
+        }
+        std::cout << Network::message_type_name(static_cast<Network::MessageType>(type)) << "\n";
+        line("delivery", latency.delivery_delay_us);
+        line("queueing", latency.queueing_delay_us);
+        line("processing", latency.processing_us);
+    }
+    
+    auto& links = stats.links;
+    auto p99 = [](const Network::LinkStats& link) { return link.delivery_delay_us.value_at_percentile(99.0); };
+    std::sort(links.begin(), links.end(), [&](const Network::LinkStats& a, const Network::LinkStats& b) {
+        return p99(a) > p99(b);
+    });
+    auto& registry = NodeRegistry::instance();
+    for (size_t i = 0; i < std::min(worst_links, links.size()); ++i) {
+        const auto& link = links[i];
+        std::cout << "  link " << registry.name(link.from_id) << " -> " << registry.name(link.to_id)
+                  << ": sent=" << link.sent << " dropped=" << link.dropped
+                  << " p99=" << p99(link) / 1000.0 << "ms\n";
+    }
+}
+
+void Simulator::begin_measurement() {
+    network.reset_stats();
+    measurement_start_ms = current_time_ms();
+    oracle.begin_window(measurement_start_ms);
+}
+
 Simulator::TestResult Simulator::collect_metrics(const std::string& test_name) {
     TestResult result;
     result.test_name = test_name;
     
     auto net_stats = network.get_stats();
     result.messages_sent = net_stats.delivered_messages + net_stats.dropped_messages;
-    result.detection_time_ms = result.messages_sent > 0 ? net_stats.total_delay / result.messages_sent : 0;
-    
-    // Count false positives and negatives
-    result.false_positives = 0;
-    result.false_negatives = 0;
-    
-    // Calculate accuracy
-    result.accuracy = calculate_accuracy(
-        result.messages_sent - (result.false_positives + result.false_negatives),
-        result.false_positives,
-        result.false_negatives
-    );
+    result.bytes_sent = net_stats.sent_bytes;
+    result.bytes_saved = net_stats.saved_bytes;
+    result.allocations_per_message = net_stats.delivered_messages > 0
+        ? static_cast<double>(net_stats.allocations) / net_stats.delivered_messages : 0.0;
+    result.delivery_p99_ms = net_stats.overall.delivery_delay_us.value_at_percentile(99.0) / 1000.0;
+    result.delivery_p999_ms = net_stats.overall.delivery_delay_us.value_at_percentile(99.9) / 1000.0;
+    result.queueing_p99_ms = net_stats.overall.queueing_delay_us.value_at_percentile(99.0) / 1000.0;
+    result.measured_ms = static_cast<double>(current_time_ms() - measurement_start_ms);
+    
+    auto report = oracle.report(current_time_ms());
+    result.detection_time_ms = report.first_detection_ms;
+    result.median_detection_ms = report.median_detection_ms;
+    result.last_detection_ms = report.last_detection_ms;
+    result.false_positives = static_cast<int>(report.false_positives);
+    result.false_negatives = static_cast<int>(report.missed);
+    result.mistake_rate = report.mistake_rate;
+    result.mean_mistake_ms = report.mean_mistake_ms;
+    result.mean_recurrence_ms = report.mean_recurrence_ms;
+    result.accuracy = report.query_accuracy;
     
     return result;
 }
-
-double Simulator::calculate_accuracy(int true_positives, int false_positives, int false_negatives) {
-    if (true_positives + false_positives + false_negatives == 0) return 1.0;
-    return static_cast<double>(true_positives) / (true_positives + false_positives + false_negatives);
-} 
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "swim_codec.hpp"
+#include "gossip_codec.hpp"
+
+namespace {
+void put_node_id(std::string& out, NodeId id) {
+    for (size_t byte = 0; byte < SwimEncoder::id_size; ++byte) {
+        out.push_back(static_cast<char>((id >> (8 * byte)) & 0xFF));
+    }
+}
+}
+
+SwimEncoder::SwimEncoder(std::string& buffer, const SwimHeader& header) : out(buffer) {
+    out.clear();
+    out.push_back(static_cast<char>(magic));
+    out.push_back(static_cast<char>(format_version));
+    out.push_back(static_cast<char>(header.type));
+    put_varint(out, header.seq);
+    put_node_id(out, header.subject);
+}
+
+void SwimEncoder::add(const SwimUpdate& update) {
+    put_node_id(out, update.id);
+    out.push_back(static_cast<char>(update.state));
+    put_varint(out, update.incarnation);
+}
+
+SwimDecoder::SwimDecoder(std::string_view buffer)
+    : data(buffer), pos(3), error(false), header{SwimMessageType::Ping, 0, invalid_node_id} {
+    if (data.size() < 3 ||
+        static_cast<uint8_t>(data[0]) != SwimEncoder::magic ||
+        static_cast<uint8_t>(data[1]) != SwimEncoder::format_version) {
+        error = true;
+        return;
+    }
+
+    uint8_t type = static_cast<uint8_t>(data[2]);
+    if (type < static_cast<uint8_t>(SwimMessageType::Ping) || type > static_cast<uint8_t>(SwimMessageType::PingReq) ||
+        !get_varint(data, pos, header.seq) || !read_id(header.subject)) {
+        error = true;
+        return;
+    }
+    header.type = static_cast<SwimMessageType>(type);
+}
+
+bool SwimDecoder::next(SwimUpdate& update) {
+    if (error || pos >= data.size()) {
+        return false;
+    }
+
+    if (!read_id(update.id) || pos >= data.size()) {
+        error = true;
+        return false;
+    }
+    uint8_t state = static_cast<uint8_t>(data[pos++]);
+    if (state > static_cast<uint8_t>(SwimMemberState::Dead) || !get_varint(data, pos, update.incarnation)) {
+        error = true;
+        return false;
+    }
+    update.state = static_cast<SwimMemberState>(state);
+    return true;
+}
+
+bool SwimDecoder::read_id(NodeId& id) {
+    if (data.size() - pos < SwimEncoder::id_size) {
+        return false;
+    }
+    id = 0;
+    for (size_t byte = 0; byte < SwimEncoder::id_size; ++byte) {
+        id |= static_cast<NodeId>(static_cast<uint8_t>(data[pos++])) << (8 * byte);
+    }
+    return true;
+}
@@ -0,0 +1,331 @@
+#include "swim_node.hpp"
+#include <algorithm>
+#include <cmath>
+
+SwimNode::SwimNode(const std::string& node_id, const std::vector<std::string>& peer_ids,
+                   std::shared_ptr<TaskScheduler> task_scheduler)
+    : Node(node_id, std::move(task_scheduler)), rng(std::random_device{}()) {
+    members.set_flip_handler([this](NodeId subject, bool failed) { report_view_change(subject, failed); });
+    
+    // Initialize node states
+    auto& registry = NodeRegistry::instance();
+    for (const auto& peer_id : peer_ids) {
+        add_member(registry.intern(peer_id));
+    }
+    add_member(numeric_id);  // Add self
+    
+    // Initialize metrics
+    metrics = {0, 0, 0, 0, get_current_time()};
+    probe_started = get_current_time();
+}
+
+void SwimNode::send_message(const std::string& to_id, const std::string& content) {
+    metrics.messages_sent++;
+    transmit(NodeRegistry::instance().intern(to_id), content);
+}
+
+void SwimNode::process_message(const Message& msg) {
+    metrics.messages_received++;
+    
+    SwimDecoder decoder(msg.content);
+    if (decoder.has_error()) {
+        return;  // Not SWIM traffic
+    }
+    
+    std::vector<Outgoing> outbox;
+    {
+        std::lock_guard<std::mutex> lock(states_mutex);
+        auto now_ms = get_current_time_ms();
+        SwimUpdate update;
+        while (decoder.next(update)) {
+            apply_update(update, now_ms);
+        }
+        
+        // A sender we buried is back; tell it so it can refute with a higher incarnation
+        if (members.contains(msg.from_id) && states[msg.from_id] == SwimMemberState::Dead) {
+            enqueue_update({msg.from_id, SwimMemberState::Dead, incarnations[msg.from_id]});
+        }
+        
+        const SwimHeader& header = decoder.get_header();
+        switch (header.type) {
+            case SwimMessageType::Ping:
+                queue_message(outbox, msg.from_id, SwimMessageType::Ack, header.seq, header.subject);
+                break;
+            case SwimMessageType::PingReq:
+                // Probe the target on the requester's behalf
+                queue_message(outbox, header.subject, SwimMessageType::Ping, header.seq, msg.from_id);
+                break;
+            case SwimMessageType::Ack:
+                if (header.subject == invalid_node_id || header.subject == numeric_id) {
+                    if (header.seq == probe_seq) {
+                        probe_acked = true;  // Direct ack, or one relayed by an indirect prober
+                    }
+                } else {
+                    queue_message(outbox, header.subject, SwimMessageType::Ack, header.seq, invalid_node_id);
+                }
+                break;
+        }
+    }
+    flush(outbox);
+}
+
+void SwimNode::periodic_task() {
+    auto now = get_current_time();
+    std::vector<Outgoing> outbox;
+    {
+        std::lock_guard<std::mutex> lock(states_mutex);
+        auto now_ms = get_current_time_ms();
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - probe_started).count();
+        
+        // Direct ping unanswered: ask k other members to try
+        if (!probe_acked && !indirect_sent && elapsed >= ping_timeout_ms) {
+            indirect_sent = true;
+            for (NodeId helper : select_random_members(indirect_probes, probe_target)) {
+                metrics.indirect_probes_sent++;
+                queue_message(outbox, helper, SwimMessageType::PingReq, probe_seq, probe_target);
+            }
+        }
+        
+        if (elapsed >= probe_interval_ms) {
+            // Nobody reached the target this period
+            if (!probe_acked && members.contains(probe_target) &&
+                states[probe_target] == SwimMemberState::Alive) {
+                SwimUpdate suspicion{probe_target, SwimMemberState::Suspect, incarnations[probe_target]};
+                set_member_state(probe_target, SwimMemberState::Suspect, incarnations[probe_target], now_ms);
+                enqueue_update(suspicion);
+            }
+            probe_started = now;
+            start_probe(outbox);
+        }
+        
+        expire_suspicions(now_ms);
+    }
+    flush(outbox);
+}
+
+void SwimNode::add_member(NodeId member_id) {
+    bool inserted = members.add(member_id, get_current_time_ms());
+    if (member_id >= states.size()) {
+        size_t new_size = static_cast<size_t>(member_id) + 1;
+        states.resize(new_size, SwimMemberState::Alive);
+        incarnations.resize(new_size, 0);
+        suspect_since_ms.resize(new_size, 0);
+    }
+    if (inserted) {
+        states[member_id] = SwimMemberState::Alive;
+        incarnations[member_id] = 0;
+    }
+}
+
+void SwimNode::start_probe(std::vector<Outgoing>& outbox) {
+    probe_target = next_probe_target();
+    probe_seq++;
+    indirect_sent = false;
+    probe_acked = probe_target == invalid_node_id;
+    if (!probe_acked) {
+        metrics.probes_sent++;
+        queue_message(outbox, probe_target, SwimMessageType::Ping, probe_seq, invalid_node_id);
+    }
+}
+
+NodeId SwimNode::next_probe_target() {
+    // Randomized round-robin: every live member is probed once per pass
+    for (int pass = 0; pass < 2; ++pass) {
+        while (probe_index < probe_order.size()) {
+            NodeId candidate = probe_order[probe_index++];
+            if (members.contains(candidate) && states[candidate] != SwimMemberState::Dead) {
+                return candidate;
+            }
+        }
+        
+        probe_order.clear();
+        for (NodeId member : members.get_members()) {
+            if (member != numeric_id && states[member] != SwimMemberState::Dead) {
+                probe_order.push_back(member);
+            }
+        }
+        std::shuffle(probe_order.begin(), probe_order.end(), rng);
+        probe_index = 0;
+    }
+    return invalid_node_id;
+}
+
+std::vector<NodeId> SwimNode::select_random_members(size_t count, NodeId exclude) {
+    std::vector<NodeId> candidates;
+    for (NodeId member : members.get_members()) {
+        if (member != numeric_id && member != exclude && states[member] != SwimMemberState::Dead) {
+            candidates.push_back(member);
+        }
+    }
+    
+    // Partial Fisher-Yates: only the first count slots need to be random
+    count = std::min(count, candidates.size());
+    for (size_t i = 0; i < count; ++i) {
+        std::uniform_int_distribution<size_t> pick(i, candidates.size() - 1);
+        std::swap(candidates[i], candidates[pick(rng)]);
+    }
+    candidates.resize(count);
+    return candidates;
+}
+
+void SwimNode::apply_update(const SwimUpdate& update, int64_t now_ms) {
+    if (update.id == numeric_id) {
+        // Refute any rumour of our own failure
+        if (update.state != SwimMemberState::Alive && update.incarnation >= incarnations[numeric_id]) {
+            incarnations[numeric_id] = update.incarnation + 1;
+            enqueue_update({numeric_id, SwimMemberState::Alive, incarnations[numeric_id]});
+        }
+        return;
+    }
+    if (!members.contains(update.id)) {
+        return;  // Unknown node; membership is configured, not joined
+    }
+    
+    // SWIM precedence: Dead beats everything at the same or newer incarnation,
+    // Suspect beats Alive at the same incarnation, and a newer incarnation beats the rest
+    SwimMemberState current = states[update.id];
+    uint64_t known = incarnations[update.id];
+    bool accept = false;
+    switch (update.state) {
+        case SwimMemberState::Alive:
+            accept = update.incarnation > known;
+            break;
+        case SwimMemberState::Suspect:
+            accept = (current == SwimMemberState::Alive && update.incarnation >= known) ||
+                     (current == SwimMemberState::Suspect && update.incarnation > known);
+            break;
+        case SwimMemberState::Dead:
+            accept = current != SwimMemberState::Dead && update.incarnation >= known;
+            break;
+    }
+    
+    if (accept) {
+        set_member_state(update.id, update.state, update.incarnation, now_ms);
+        enqueue_update(update);
+    }
+}
+
+void SwimNode::set_member_state(NodeId member_id, SwimMemberState state, uint64_t incarnation, int64_t now_ms) {
+    if (state == SwimMemberState::Suspect && states[member_id] != SwimMemberState::Suspect) {
+        suspect_since_ms[member_id] = now_ms;
+        suspects.push_back(member_id);
+    } else if (state != SwimMemberState::Suspect && states[member_id] == SwimMemberState::Suspect) {
+        suspects.erase(std::remove(suspects.begin(), suspects.end(), member_id), suspects.end());
+    }
+    
+    states[member_id] = state;
+    incarnations[member_id] = incarnation;
+    members.set_alive(member_id, state != SwimMemberState::Dead);
+    if (state == SwimMemberState::Alive) {
+        members.mark_seen(member_id, now_ms);
+    }
+}
+
+void SwimNode::expire_suspicions(int64_t now_ms) {
+    std::vector<NodeId> expired;
+    for (NodeId member : suspects) {
+        if (now_ms - suspect_since_ms[member] >= suspicion_timeout_ms) {
+            expired.push_back(member);
+        }
+    }
+    for (NodeId member : expired) {
+        set_member_state(member, SwimMemberState::Dead, incarnations[member], now_ms);
+        enqueue_update({member, SwimMemberState::Dead, incarnations[member]});
+    }
+}
+
+void SwimNode::enqueue_update(const SwimUpdate& update) {
+    // A newer update about the same member replaces the one still in flight
+    for (auto& pending : pending_updates) {
+        if (pending.update.id == update.id) {
+            pending = PendingUpdate{update, 0};
+            return;
+        }
+    }
+    pending_updates.push_back(PendingUpdate{update, 0});
+}
+
+void SwimNode::queue_message(std::vector<Outgoing>& outbox, NodeId to_id, SwimMessageType type,
+                             uint64_t seq, NodeId subject) {
+    outbox.push_back(Outgoing{to_id, std::string()});
+    SwimEncoder encoder(outbox.back().content, SwimHeader{type, seq, subject});
+    
+    // Least-transmitted updates first, so fresh news spreads fastest
+    size_t count = std::min(pending_updates.size(), static_cast<size_t>(max_piggyback));
+    std::partial_sort(pending_updates.begin(), pending_updates.begin() + count, pending_updates.end(),
+                      [](const PendingUpdate& a, const PendingUpdate& b) {
+                          return a.transmissions < b.transmissions;
+                      });
+    for (size_t i = 0; i < count; ++i) {
+        encoder.add(pending_updates[i].update);
+        pending_updates[i].transmissions++;
+    }
+    
+    int limit = retransmit_limit();
+    pending_updates.erase(std::remove_if(pending_updates.begin(), pending_updates.end(),
+                                         [limit](const PendingUpdate& pending) {
+                                             return pending.transmissions >= limit;
+                                         }),
+                          pending_updates.end());
+}
+
+int SwimNode::retransmit_limit() const {
+    return retransmit_mult * static_cast<int>(std::ceil(std::log2(members.size() + 1.0)));
+}
+
+void SwimNode::flush(std::vector<Outgoing>& outbox) {
+    for (auto& out : outbox) {
+        metrics.messages_sent++;
+        transmit(out.to_id, out.content);
+    }
+}
+
+std::vector<std::string> SwimNode::get_failed_nodes() const {
+    std::vector<std::string> failed;
+    auto& registry = NodeRegistry::instance();
+    for (NodeId node_id : get_failed_node_ids()) {
+        failed.push_back(registry.name(node_id));
+    }
+    return failed;
+}
+
+std::vector<NodeId> SwimNode::get_failed_node_ids() const {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    return members.collect_failed();
+}
+
+bool SwimNode::is_node_failed(NodeId node_id) const {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    return members.contains(node_id) && !members.is_alive(node_id);
+}
+
+SwimMemberState SwimNode::get_member_state(NodeId node_id) const {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    return members.contains(node_id) ? states[node_id] : SwimMemberState::Dead;
+}
+
+uint64_t SwimNode::get_incarnation() const {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    return incarnations[numeric_id];
+}
+
+void SwimNode::add_peer(const std::string& peer_id) {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    add_member(NodeRegistry::instance().intern(peer_id));
+}
+
+void SwimNode::remove_peer(const std::string& peer_id) {
+    NodeId peer = NodeRegistry::instance().find(peer_id);
+    std::lock_guard<std::mutex> lock(states_mutex);
+    if (members.remove(peer) && states[peer] == SwimMemberState::Suspect) {
+        suspects.erase(std::remove(suspects.begin(), suspects.end(), peer), suspects.end());
+    }
+}
+
+SwimNode::Metrics SwimNode::get_metrics() const {
+    return metrics;
+}
+
+void SwimNode::reset_metrics() {
+    metrics = {0, 0, 0, 0, get_current_time()};
+}
@@ -0,0 +1,88 @@
+#include "trace_recorder.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstring>
+
+TraceRecorder::TraceRecorder() : fd(-1), mapping(nullptr), mapped_bytes(0), records(0) {}
+
+TraceRecorder::~TraceRecorder() {
+    close();
+}
+
+bool TraceRecorder::open(const std::string& file_path, uint64_t seed) {
+    close();
+    std::lock_guard<std::mutex> lock(mutex);
+    fd = ::open(file_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    if (!remap(initial_bytes)) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    path = file_path;
+    records = 0;
+    TraceHeader header{{'F', 'D', 'T', 'R'}, 1, seed, 0, 0};
+    std::memcpy(mapping, &header, sizeof(header));
+    return true;
+}
+
+bool TraceRecorder::remap(size_t bytes) {
+    if (mapping) {
+        munmap(mapping, mapped_bytes);
+        mapping = nullptr;
+    }
+    if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        return false;
+    }
+    void* address = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+        return false;
+    }
+    mapping = static_cast<char*>(address);
+    mapped_bytes = bytes;
+    return true;
+}
+
+void TraceRecorder::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fd < 0) {
+        return;
+    }
+    if (mapping) {
+        std::memcpy(mapping + offsetof(TraceHeader, records), &records, sizeof(records));
+        munmap(mapping, mapped_bytes);
+        mapping = nullptr;
+    }
+    ssize_t trimmed = ftruncate(fd, static_cast<off_t>(sizeof(TraceHeader) + records * sizeof(TraceRecord)));
+    (void)trimmed;
+    ::close(fd);
+    fd = -1;
+    mapped_bytes = 0;
+}
+
+bool TraceRecorder::is_open() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return mapping != nullptr;
+}
+
+void TraceRecorder::record(TraceEvent type, int64_t time_ms, NodeId subject, NodeId peer, uint32_t size) {
+    TraceRecord entry{time_ms, subject, peer, size, static_cast<uint8_t>(type), {0, 0, 0}};
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!mapping) {
+        return;
+    }
+    size_t offset = sizeof(TraceHeader) + records * sizeof(TraceRecord);
+    if (offset + sizeof(TraceRecord) > mapped_bytes && !remap(mapped_bytes * 2)) {
+        return;  // Out of disk: the trace simply ends here
+    }
+    std::memcpy(mapping + offset, &entry, sizeof(entry));
+    records++;
+}
+
+uint64_t TraceRecorder::get_record_count() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return records;
+}
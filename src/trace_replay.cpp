@@ -0,0 +1,235 @@
+#include "trace_replay.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+
+namespace {
+
+// Suspicion sets of every observer plus the injected ground truth
+class ReplayState {
+private:
+    std::unordered_set<uint64_t> suspected;  // observer << 32 | subject
+    std::vector<size_t> suspected_by;        // Observers suspecting each subject
+    std::vector<uint8_t> crashed;
+    size_t false_positives = 0;
+
+    void grow(NodeId id) {
+        if (id != invalid_node_id && id >= crashed.size()) {
+            crashed.resize(static_cast<size_t>(id) + 1, 0);
+            suspected_by.resize(crashed.size(), 0);
+        }
+    }
+
+public:
+    // Returns true for a new false suspicion
+    bool apply(const TraceRecord& record) {
+        grow(record.subject);
+        grow(record.peer);
+        uint64_t key = (uint64_t{record.subject} << 32) | record.peer;
+        switch (static_cast<TraceEvent>(record.type)) {
+            case TraceEvent::Suspect:
+                if (suspected.insert(key).second) {
+                    suspected_by[record.peer]++;
+                    if (!crashed[record.peer]) {
+                        false_positives++;
+                        return true;
+                    }
+                }
+                break;
+            case TraceEvent::Clear:
+                if (suspected.erase(key) > 0) {
+                    suspected_by[record.peer]--;
+                    if (!crashed[record.peer]) {
+                        false_positives--;
+                    }
+                }
+                break;
+            case TraceEvent::Crash:
+                if (!crashed[record.subject]) {
+                    crashed[record.subject] = 1;
+                    false_positives -= suspected_by[record.subject];
+                }
+                break;
+            case TraceEvent::Recover:
+                if (crashed[record.subject]) {
+                    crashed[record.subject] = 0;
+                    false_positives += suspected_by[record.subject];
+                }
+                break;
+            case TraceEvent::Leave:
+                // Forget the node as observer and as subject; a later node may reuse the id
+                for (auto it = suspected.begin(); it != suspected.end();) {
+                    NodeId observer = static_cast<NodeId>(*it >> 32);
+                    NodeId subject = static_cast<NodeId>(*it & 0xffffffffu);
+                    if (observer == record.subject || subject == record.subject) {
+                        suspected_by[subject]--;
+                        if (!crashed[subject]) {
+                            false_positives--;
+                        }
+                        it = suspected.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+                crashed[record.subject] = 0;
+                break;
+            default:
+                break;
+        }
+        return false;
+    }
+
+    size_t get_false_positives() const { return false_positives; }
+};
+
+}  // namespace
+
+TraceReplay::TraceReplay() : fd(-1), mapping(nullptr), mapped_bytes(0), header{}, records(nullptr), count(0) {}
+
+TraceReplay::~TraceReplay() {
+    close();
+}
+
+bool TraceReplay::open(const std::string& file_path) {
+    close();
+    fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(TraceHeader)) {
+        close();
+        return false;
+    }
+    mapped_bytes = static_cast<size_t>(info.st_size);
+    void* address = mmap(nullptr, mapped_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) {
+        mapped_bytes = 0;
+        close();
+        return false;
+    }
+    mapping = static_cast<const char*>(address);
+    std::memcpy(&header, mapping, sizeof(header));
+    if (std::memcmp(header.magic, "FDTR", 4) != 0 || header.version != 1) {
+        close();
+        return false;
+    }
+    // A recorder that never closed leaves the count at 0 and zeroed slack at the end
+    size_t available = (mapped_bytes - sizeof(TraceHeader)) / sizeof(TraceRecord);
+    records = reinterpret_cast<const TraceRecord*>(mapping + sizeof(TraceHeader));
+    count = header.records > 0 ? std::min<size_t>(header.records, available) : available;
+    while (header.records == 0 && count > 0 && records[count - 1].type == 0) {
+        count--;
+    }
+    return true;
+}
+
+void TraceReplay::close() {
+    if (mapping) {
+        munmap(const_cast<char*>(mapping), mapped_bytes);
+        mapping = nullptr;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    mapped_bytes = 0;
+    records = nullptr;
+    count = 0;
+    header = TraceHeader{};
+}
+
+TraceReplay::Summary TraceReplay::summarize() const {
+    Summary summary{};
+    ReplayState state;
+    for (size_t i = 0; i < count; ++i) {
+        const TraceRecord& record = records[i];
+        switch (static_cast<TraceEvent>(record.type)) {
+            case TraceEvent::Send: summary.sends++; break;
+            case TraceEvent::Drop: summary.drops++; break;
+            case TraceEvent::Deliver: summary.deliveries++; break;
+            case TraceEvent::Suspect: summary.suspicions++; break;
+            case TraceEvent::Clear: summary.clears++; break;
+            case TraceEvent::Crash: summary.crashes++; break;
+            case TraceEvent::Recover: summary.recoveries++; break;
+            case TraceEvent::Leave: break;
+        }
+        if (state.apply(record)) {
+            summary.false_suspicions++;
+        }
+        if (state.get_false_positives() > summary.peak_false_positives) {
+            summary.peak_false_positives = state.get_false_positives();
+            summary.peak_time_ms = record.time_ms;
+        }
+        summary.end_time_ms = std::max(summary.end_time_ms, record.time_ms);
+    }
+    return summary;
+}
+
+std::vector<TraceReplay::Bucket> TraceReplay::timeline(int64_t bucket_ms) const {
+    std::vector<Bucket> buckets;
+    if (count == 0 || bucket_ms <= 0) {
+        return buckets;
+    }
+    ReplayState state;
+    int64_t origin = records[0].time_ms;
+    for (size_t i = 0; i < count; ++i) {
+        const TraceRecord& record = records[i];
+        size_t index = static_cast<size_t>(std::max<int64_t>(0, record.time_ms - origin) / bucket_ms);
+        while (buckets.size() <= index) {
+            size_t carried = buckets.empty() ? 0 : buckets.back().false_positives;
+            buckets.push_back({origin + static_cast<int64_t>(buckets.size()) * bucket_ms, 0, 0, carried});
+        }
+        Bucket& bucket = buckets[index];
+        if (static_cast<TraceEvent>(record.type) == TraceEvent::Send ||
+            static_cast<TraceEvent>(record.type) == TraceEvent::Drop) {
+            bucket.messages++;
+        }
+        if (state.apply(record)) {
+            bucket.false_suspicions++;
+        }
+        bucket.false_positives = state.get_false_positives();
+    }
+    return buckets;
+}
+
+size_t TraceReplay::false_positives_at(int64_t time_ms) const {
+    ReplayState state;
+    replay(time_ms, [&](const TraceRecord& record) { state.apply(record); });
+    return state.get_false_positives();
+}
+
+int64_t TraceReplay::find_false_positive_onset(size_t threshold) const {
+    if (count == 0) {
+        return -1;
+    }
+    // Once reached, the count can fall again, so bisect on "reached by time t"
+    // rather than on the instantaneous value
+    auto reached_by = [&](int64_t time_ms) {
+        ReplayState state;
+        bool reached = false;
+        replay(time_ms, [&](const TraceRecord& record) {
+            state.apply(record);
+            reached = reached || state.get_false_positives() >= threshold;
+        });
+        return reached;
+    };
+    int64_t low = records[0].time_ms;
+    int64_t high = records[count - 1].time_ms;
+    if (!reached_by(high)) {
+        return -1;
+    }
+    while (low < high) {
+        int64_t middle = low + (high - low) / 2;
+        if (reached_by(middle)) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return low;
+}
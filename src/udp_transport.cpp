@@ -0,0 +1,285 @@
+#include "udp_transport.hpp"
+#include "node.hpp"
+#include "envelope_pool.hpp"
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+
+namespace {
+
+constexpr size_t id_bytes = 4;
+
+void put_id(std::string& out, NodeId id) {
+    for (size_t i = 0; i < id_bytes; ++i) {
+        out.push_back(static_cast<char>((id >> (8 * i)) & 0xff));
+    }
+}
+
+NodeId get_id(const char* in) {
+    NodeId id = 0;
+    for (size_t i = 0; i < id_bytes; ++i) {
+        id |= static_cast<NodeId>(static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    return id;
+}
+
+}  // namespace
+
+UdpTransport::UdpTransport()
+    : send_fd(socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)),
+      epoll_fd(epoll_create1(EPOLL_CLOEXEC)),
+      wake_fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      outbox(max_batch), send_headers(max_batch), send_iovecs(max_batch),
+      receive_buffer(max_batch * max_datagram), receive_headers(max_batch), receive_iovecs(max_batch),
+      running(false), datagrams_sent(0), datagrams_received(0), send_calls(0),
+      receive_calls(0), bytes_sent(0), dropped(0) {
+    if (epoll_fd >= 0 && wake_fd >= 0) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = invalid_node_id;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event);
+    }
+}
+
+UdpTransport::~UdpTransport() {
+    stop();
+    {
+        std::lock_guard<std::mutex> lock(endpoints_mutex);
+        for (auto& endpoint : endpoints) {
+            if (endpoint.node) {
+                endpoint.node->attach_transport(nullptr);
+            }
+            if (endpoint.fd >= 0) {
+                close(endpoint.fd);
+            }
+        }
+        endpoints.clear();
+    }
+    for (int fd : {send_fd, epoll_fd, wake_fd}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+bool UdpTransport::add_node(std::shared_ptr<Node> node) {
+    if (!is_open()) {
+        return false;
+    }
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    // Room for a burst of gossip while the loop is busy elsewhere
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receive_buffer_bytes, sizeof(receive_buffer_bytes));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;  // Let the kernel pick
+    socklen_t length = sizeof(address);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        close(fd);
+        return false;
+    }
+
+    NodeId id = node->get_numeric_id();
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = id;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        close(fd);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(endpoints_mutex);
+    if (id >= endpoints.size()) {
+        endpoints.resize(static_cast<size_t>(id) + 1);
+    }
+    if (endpoints[id].fd >= 0) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, endpoints[id].fd, nullptr);
+        close(endpoints[id].fd);
+    }
+    node->attach_transport(this);
+    endpoints[id] = Endpoint{fd, address, std::move(node)};
+    return true;
+}
+
+void UdpTransport::remove_node(NodeId node_id) {
+    std::lock_guard<std::mutex> lock(endpoints_mutex);
+    if (node_id >= endpoints.size() || endpoints[node_id].fd < 0) {
+        return;
+    }
+    Endpoint& endpoint = endpoints[node_id];
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, endpoint.fd, nullptr);
+    close(endpoint.fd);
+    endpoint.node->attach_transport(nullptr);
+    endpoint = Endpoint{};
+}
+
+void UdpTransport::start() {
+    if (running || !is_open()) {
+        return;
+    }
+    running = true;
+    loop_thread = std::thread(&UdpTransport::event_loop, this);
+}
+
+void UdpTransport::stop() {
+    if (!running) {
+        return;
+    }
+    running = false;
+    uint64_t one = 1;
+    ssize_t written = write(wake_fd, &one, sizeof(one));
+    (void)written;
+    if (loop_thread.joinable()) {
+        loop_thread.join();
+    }
+    flush();
+}
+
+void UdpTransport::send_message(NodeId from_id, NodeId to_id, const std::string& content,
+                                size_t /*full_state_bytes*/) {
+    sockaddr_in address;
+    {
+        std::lock_guard<std::mutex> lock(endpoints_mutex);
+        if (to_id >= endpoints.size() || endpoints[to_id].fd < 0) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        address = endpoints[to_id].address;
+    }
+    if (content.size() + id_bytes > max_datagram) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(outbox_mutex);
+    Outgoing& slot = outbox[outbox_size++];
+    slot.address = address;
+    slot.datagram.clear();
+    put_id(slot.datagram, from_id);
+    slot.datagram.append(content);
+    if (outbox_size == max_batch) {
+        flush_locked();
+    }
+}
+
+void UdpTransport::flush() {
+    std::lock_guard<std::mutex> lock(outbox_mutex);
+    flush_locked();
+}
+
+void UdpTransport::flush_locked() {
+    if (outbox_size == 0) {
+        return;
+    }
+    for (size_t i = 0; i < outbox_size; ++i) {
+        send_iovecs[i].iov_base = outbox[i].datagram.data();
+        send_iovecs[i].iov_len = outbox[i].datagram.size();
+        send_headers[i].msg_hdr = msghdr{};
+        send_headers[i].msg_hdr.msg_name = &outbox[i].address;
+        send_headers[i].msg_hdr.msg_namelen = sizeof(outbox[i].address);
+        send_headers[i].msg_hdr.msg_iov = &send_iovecs[i];
+        send_headers[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    size_t sent = 0;
+    while (sent < outbox_size) {
+        int result = sendmmsg(send_fd, &send_headers[sent], static_cast<unsigned int>(outbox_size - sent), 0);
+        send_calls.fetch_add(1, std::memory_order_relaxed);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // The kernel refused the head of the batch; drop it like a lossy link and move on
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            sent++;
+            continue;
+        }
+        for (int i = 0; i < result; ++i) {
+            bytes_sent.fetch_add(send_iovecs[sent + i].iov_len, std::memory_order_relaxed);
+        }
+        datagrams_sent.fetch_add(result, std::memory_order_relaxed);
+        sent += static_cast<size_t>(result);
+    }
+    outbox_size = 0;
+}
+
+void UdpTransport::event_loop() {
+    epoll_event events[max_batch];
+    while (running) {
+        int ready = epoll_wait(epoll_fd, events, static_cast<int>(max_batch), flush_interval_ms);
+        for (int i = 0; i < ready; ++i) {
+            NodeId id = static_cast<NodeId>(events[i].data.u64);
+            if (events[i].data.u64 == invalid_node_id) {
+                uint64_t count;
+                ssize_t drained = read(wake_fd, &count, sizeof(count));
+                (void)drained;
+                continue;
+            }
+            int fd = -1;
+            {
+                std::lock_guard<std::mutex> lock(endpoints_mutex);
+                if (id < endpoints.size()) {
+                    fd = endpoints[id].fd;
+                }
+            }
+            if (fd >= 0) {
+                receive_batch(id, fd);
+            }
+        }
+        flush();  // Anything queued since the last pass goes out now
+    }
+}
+
+void UdpTransport::receive_batch(NodeId node_id, int fd) {
+    for (size_t i = 0; i < max_batch; ++i) {
+        receive_iovecs[i].iov_base = receive_buffer.data() + i * max_datagram;
+        receive_iovecs[i].iov_len = max_datagram;
+        receive_headers[i].msg_hdr = msghdr{};
+        receive_headers[i].msg_hdr.msg_iov = &receive_iovecs[i];
+        receive_headers[i].msg_hdr.msg_iovlen = 1;
+    }
+    int received = recvmmsg(fd, receive_headers.data(), static_cast<unsigned int>(max_batch), MSG_DONTWAIT, nullptr);
+    if (received <= 0) {
+        return;
+    }
+    receive_calls.fetch_add(1, std::memory_order_relaxed);
+    datagrams_received.fetch_add(received, std::memory_order_relaxed);
+
+    std::shared_ptr<Node> node;
+    {
+        std::lock_guard<std::mutex> lock(endpoints_mutex);
+        if (node_id < endpoints.size()) {
+            node = endpoints[node_id].node;
+        }
+    }
+    if (!node) {
+        return;
+    }
+
+    auto& pool = EnvelopePool::instance();
+    uint64_t allocations = 0;
+    for (int i = 0; i < received; ++i) {
+        size_t length = receive_headers[i].msg_len;
+        if (length < id_bytes) {
+            continue;  // Not one of ours
+        }
+        const char* data = static_cast<const char*>(receive_iovecs[i].iov_base);
+        Envelope* envelope = pool.acquire(allocations);
+        envelope->from_id = get_id(data);
+        envelope->to_id = node_id;
+        envelope->content.assign(data + id_bytes, length - id_bytes);
+        node->receive_envelope(envelope);
+    }
+}
+
+UdpTransport::Stats UdpTransport::get_stats() const {
+    return Stats{datagrams_sent.load(), datagrams_received.load(), send_calls.load(),
+                 receive_calls.load(), bytes_sent.load(), dropped.load()};
+}
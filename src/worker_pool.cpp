@@ -0,0 +1,165 @@
+#include "worker_pool.hpp"
+#include <algorithm>
+
+namespace {
+// Lets a task submitted from a worker land on that worker's own deque
+thread_local const WorkerPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+}
+
+WorkerPool::WorkerPool(size_t num_threads)
+    : queued_tasks(0), next_seq(0), running(true), next_worker(0),
+      executed_tasks(0), stolen_tasks(0) {
+    num_threads = std::max<size_t>(1, num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < num_threads; ++i) {
+        worker_threads.emplace_back(&WorkerPool::worker_loop, this, i);
+    }
+    timer_thread = std::thread(&WorkerPool::timer_loop, this);
+}
+
+WorkerPool::~WorkerPool() {
+    shutdown();
+}
+
+WorkerPool::TimePoint WorkerPool::now() const {
+    return std::chrono::system_clock::now();
+}
+
+void WorkerPool::schedule_at(TimePoint when, Callback callback) {
+    if (when <= now()) {
+        submit(std::move(callback));
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(timers_mutex);
+        bool new_earliest = timers.empty() || when < timers.top().time;
+        timers.push({when, next_seq++, std::move(callback)});
+        if (!new_earliest) {
+            return;
+        }
+    }
+    timers_cv.notify_one();
+}
+
+void WorkerPool::submit(Callback callback) {
+    if (!running) {
+        return;
+    }
+
+    size_t index = (current_pool == this)
+        ? current_worker
+        : next_worker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+    {
+        std::lock_guard<std::mutex> lock(workers[index]->mutex);
+        workers[index]->tasks.push_back(std::move(callback));
+    }
+    queued_tasks.fetch_add(1, std::memory_order_release);
+    {
+        // Pair with the predicate check in worker_loop so the wakeup is never lost
+        std::lock_guard<std::mutex> lock(idle_mutex);
+    }
+    idle_cv.notify_one();
+}
+
+void WorkerPool::shutdown() {
+    if (!running.exchange(false)) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(timers_mutex);
+    }
+    timers_cv.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex);
+    }
+    idle_cv.notify_all();
+
+    if (timer_thread.joinable()) {
+        timer_thread.join();
+    }
+    for (auto& thread : worker_threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+bool WorkerPool::pop_task(size_t index, Callback& out) {
+    // Own deque first (LIFO keeps a node's follow-up work cache-hot)
+    {
+        std::lock_guard<std::mutex> lock(workers[index]->mutex);
+        if (!workers[index]->tasks.empty()) {
+            out = std::move(workers[index]->tasks.back());
+            workers[index]->tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Then steal the oldest task from another worker
+    for (size_t offset = 1; offset < workers.size(); ++offset) {
+        auto& victim = *workers[(index + offset) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            out = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            stolen_tasks.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerPool::worker_loop(size_t index) {
+    current_pool = this;
+    current_worker = index;
+
+    while (running) {
+        Callback task;
+        if (pop_task(index, task)) {
+            queued_tasks.fetch_sub(1, std::memory_order_acq_rel);
+            task();
+            executed_tasks.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(idle_mutex);
+        idle_cv.wait(lock, [this]() {
+            return !running || queued_tasks.load(std::memory_order_acquire) > 0;
+        });
+    }
+}
+
+void WorkerPool::timer_loop() {
+    std::unique_lock<std::mutex> lock(timers_mutex);
+    while (running) {
+        if (timers.empty()) {
+            timers_cv.wait(lock);
+            continue;
+        }
+
+        auto next_time = timers.top().time;
+        if (next_time > now()) {
+            timers_cv.wait_until(lock, next_time);
+            continue;
+        }
+
+        // Collect everything that is due, then hand it over without the timer lock
+        std::vector<Callback> due;
+        auto current = now();
+        while (!timers.empty() && timers.top().time <= current) {
+            due.push_back(std::move(const_cast<Timer&>(timers.top()).callback));
+            timers.pop();
+        }
+
+        lock.unlock();
+        for (auto& callback : due) {
+            submit(std::move(callback));
+        }
+        lock.lock();
+    }
+}